@@ -0,0 +1,531 @@
+/*
+ * bench.c - So Lang Throughput Benchmark Suite
+ * Generates synthetic corpora of several shapes, measures each compiler
+ * phase, writes the results as JSON and compares them with a baseline,
+ * rates relative to a calibration loop timed alongside each phase
+ */
+
+#define _DEFAULT_SOURCE
+
+#include <stdarg.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+// Pull in the bootstrap compiler; its main() is renamed out of the way
+#define main solang_enhanced_main
+#include "../src/so_lang_enhanced.c"
+#undef main
+
+#include "../src/so_lang_scan.h"
+#include "../src/so_lang_solana.h"
+#include "bench_timer.h"
+
+#define DEFAULT_SIZE_MB 16
+#define DEFAULT_RUNS 9
+#define DEFAULT_TOLERANCE 0.30
+#define MAX_RESULTS 64
+
+// ============================================================================
+// CORPUS GENERATION
+// ============================================================================
+
+typedef struct {
+    char* data;
+    size_t length;
+    size_t capacity;
+} Corpus;
+
+static void corpus_printf(Corpus* corpus, const char* format, ...) {
+    va_list args;
+    for (;;) {
+        size_t room = corpus->capacity - corpus->length;
+        va_start(args, format);
+        int n = vsnprintf(corpus->data + corpus->length, room, format, args);
+        va_end(args);
+        if ((size_t)n < room) {
+            corpus->length += n;
+            return;
+        }
+        corpus->capacity *= 2;
+        corpus->data = realloc(corpus->data, corpus->capacity);
+    }
+}
+
+// Nested if blocks inside small functions
+static void shape_nesting(Corpus* corpus, int i) {
+    const int depth = 24;
+    corpus_printf(corpus, "fn nested_%d() {\n", i);
+    for (int d = 0; d < depth; d++) {
+        corpus_printf(corpus, "%*sif level_%d > %d {\n", 4 * (d + 1), "", d, d);
+    }
+    corpus_printf(corpus, "%*slet innermost = level_0 + %d\n", 4 * (depth + 1), "", i);
+    for (int d = depth - 1; d >= 0; d--) {
+        corpus_printf(corpus, "%*s}\n", 4 * (d + 1), "");
+    }
+    corpus_printf(corpus, "}\n");
+}
+
+// Long statements made almost entirely of long identifiers
+static void shape_identifiers(Corpus* corpus, int i) {
+    corpus_printf(corpus,
+        "let account_balance_after_transfer_%d = sender_balance_before_transfer_%d - transfer_amount_in_lamports\n"
+        "let recipient_balance_after_transfer_%d = recipient_balance_before_transfer + transfer_amount_in_lamports\n"
+        "print(account_balance_after_transfer_%d)\n",
+        i, i, i, i);
+}
+
+// Solana instructions with account attributes and typed parameters
+static void shape_instructions(Corpus* corpus, int i) {
+    corpus_printf(corpus,
+        "instruction transfer_%d(\n"
+        "    @account(signer, writable) sender: TokenAccount,\n"
+        "    @account(writable) recipient: TokenAccount,\n"
+        "    amount: u64\n"
+        ") {\n"
+        "    require(sender_balance >= amount, \"Insufficient funds\")\n"
+        "    transfer(sender, recipient, amount)\n"
+        "    let remaining = sender_balance - amount\n"
+        "}\n\n",
+        i);
+}
+
+// Wide state structs
+static void shape_state(Corpus* corpus, int i) {
+    static const char* const types[] = {"u64", "pubkey", "u8", "bool", "u32"};
+    corpus_printf(corpus, "state VaultAccount%d {\n", i);
+    for (int f = 0; f < 32; f++) {
+        corpus_printf(corpus, "    field_%d: %s%s\n", f, types[f % 5], f < 31 ? "," : "");
+    }
+    corpus_printf(corpus, "}\n\n");
+}
+
+// Solana shapes run through so_lang_solana.c, which wants one program per
+// file; the prologue and epilogue put the units in or next to it
+typedef struct {
+    const char* name;
+    LexerDialect dialect;   // LEXER_DIALECT_SOLANA picks the Solana frontend
+    const char* prologue;
+    const char* epilogue;
+    void (*unit)(Corpus* corpus, int i);
+} Shape;
+
+static const Shape SHAPES[] = {
+    {"nesting",      LEXER_DIALECT_CORE,   "",                       "",    shape_nesting},
+    {"identifiers",  LEXER_DIALECT_CORE,   "",                       "",    shape_identifiers},
+    {"instructions", LEXER_DIALECT_SOLANA, "program Bench {\n",      "}\n", shape_instructions},
+    {"state",        LEXER_DIALECT_SOLANA, "program Bench {\n}\n\n", "",    shape_state},
+};
+
+#define SHAPE_COUNT ((int)(sizeof(SHAPES) / sizeof(SHAPES[0])))
+
+static char* generate_corpus(const Shape* shape, size_t size) {
+    Corpus corpus = {malloc(size + 4096), 0, size + 4096};
+    corpus_printf(&corpus, "%s", shape->prologue);
+    for (int i = 0; corpus.length < size; i++) {
+        shape->unit(&corpus, i);
+    }
+    corpus_printf(&corpus, "%s", shape->epilogue);
+    return corpus.data;
+}
+
+// ============================================================================
+// PHASES
+// ============================================================================
+
+typedef enum { PHASE_LEX, PHASE_PARSE, PHASE_EMIT } Phase;
+
+static const char* const PHASE_NAMES[] = {"lex", "parse", "emit"};
+static const char* const PHASE_UNITS[] = {"tokens", "nodes", "bytes"};
+
+typedef struct {
+    char shape[32];
+    char phase[8];
+    char unit[8];
+    long input_bytes;
+    long items;
+    double seconds;
+    double calibration_seconds;
+    long peak_rss_kb;
+    bool ok;
+} BenchResult;
+
+// A fixed byte loop (FNV-1a) that shares nothing with the compiler, so no
+// change to the compiler can move it. Each phase run is paired with one pass
+// over the same input; dividing by its rate leaves what the compiler did
+// rather than how fast the host happened to be
+static uint32_t calibration_pass(const char* data, long length) {
+    uint32_t hash = 2166136261u;
+    for (long i = 0; i < length; i++) hash = (hash ^ (unsigned char)data[i]) * 16777619u;
+    return hash;
+}
+
+static long ast_count_nodes(ASTNode* node) {
+    if (!node) return 0;
+    long count = 1;
+
+    switch (node->type) {
+        case NODE_BINARY_OP:
+        case NODE_REQUIRE_STMT:
+            count += ast_count_nodes(node->as.binary.left);
+            count += ast_count_nodes(node->as.binary.right);
+            break;
+        case NODE_FUNC_DECL:
+            count += ast_count_nodes(node->as.function.params);
+            count += ast_count_nodes(node->as.function.body);
+            break;
+        case NODE_VAR_DECL:
+        case NODE_PRINT_STMT:
+        case NODE_RETURN_STMT:
+        case NODE_UNARY_OP:
+        case NODE_MEMBER_ACCESS:
+            count += ast_count_nodes(node->as.operand);
+            break;
+        case NODE_PROGRAM:
+        case NODE_IF_STMT:
+        case NODE_FUNC_CALL:
+        case NODE_PROGRAM_DECL:
+        case NODE_TRANSFER_STMT:
+            for (int i = 0; i < node->as.list.count; i++) {
+                count += ast_count_nodes(node->as.list.items[i]);
+            }
+            break;
+        // Parameters and fields live in side tables; each counts as a node
+        case NODE_INSTRUCTION_DECL:
+            count += node->as.instruction.params ? node->as.instruction.params->count : 0;
+            count += ast_count_nodes(node->as.instruction.body);
+            break;
+        case NODE_STATE_DECL:
+        case NODE_EVENT_DECL:
+        case NODE_ENUM_DECL:
+        case NODE_ERROR_DECL:
+            count += node->as.layout ? node->as.layout->field_count : 0;
+            break;
+        default:
+            break;
+    }
+    return count;
+}
+
+// Parser threads; 1 keeps results comparable with single-threaded baselines
+static int parse_jobs = 1;
+
+static void reset_frontend(void) {
+    diag_reset();
+    parser_functions_free();
+}
+
+// Parsing pulls tokens on demand, so the parse phase includes lexing
+static ASTNode* parse_source(const Shape* shape, char* source, Arena* arena, Lexer** lexer_out) {
+    reset_frontend();
+    Lexer* lexer = lexer_create(source, shape->dialect);
+    Parser* parser = parser_create(lexer, arena);
+    parser->jobs = parse_jobs;
+    ASTNode* ast = shape->dialect == LEXER_DIALECT_SOLANA ? solana_parser_parse_file(parser)
+                                                          : parser_parse(parser);
+    parser_free(parser);
+    *lexer_out = lexer;
+    return ast;
+}
+
+static void run_phase(const Shape* shape, Phase phase, char* source, int runs, BenchResult* result) {
+    BenchTimer timer = {0};
+    BenchTimer calibration = {0};
+    volatile uint32_t sink = 0;
+    result->ok = true;
+
+    for (int run = 0; run < runs && result->ok; run++) {
+        bench_timer_start(&calibration);
+        sink ^= calibration_pass(source, result->input_bytes);
+        bench_timer_stop(&calibration);
+
+        Lexer* lexer = NULL;
+        Arena arena;
+        arena_init(&arena);
+
+        if (phase == PHASE_LEX) {
+            reset_frontend();
+            lexer = lexer_create(source, shape->dialect);
+            bench_timer_start(&timer);
+            lexer_tokenize(lexer);
+            bench_timer_stop(&timer);
+            result->items = lexer->token_count;
+        } else if (phase == PHASE_PARSE) {
+            bench_timer_start(&timer);
+            ASTNode* ast = parse_source(shape, source, &arena, &lexer);
+            bench_timer_stop(&timer);
+            result->items = ast_count_nodes(ast);
+        } else {
+            ASTNode* ast = parse_source(shape, source, &arena, &lexer);
+            char* buffer = NULL;
+            size_t length = 0;
+            FILE* output = open_memstream(&buffer, &length);
+
+            // Solana shapes are emitted as Anchor programs, the others as C
+            if (shape->dialect == LEXER_DIALECT_SOLANA) {
+                SolanaCompiler* compiler = solana_compiler_create(output, true);
+                bench_timer_start(&timer);
+                solana_compiler_compile(compiler, ast);
+                fflush(output);
+                bench_timer_stop(&timer);
+                solana_compiler_free(compiler);
+            } else {
+                Compiler* compiler = compiler_create(output, false);
+                bench_timer_start(&timer);
+                compiler_compile(compiler, ast);
+                fflush(output);
+                bench_timer_stop(&timer);
+                compiler_free(compiler);
+            }
+
+            result->items = (long)length;
+            fclose(output);
+            free(buffer);
+        }
+
+        if (diag_error_count()) result->ok = false;
+        arena_free(&arena);
+        lexer_free(lexer);
+    }
+
+    (void)sink;
+    result->seconds = bench_timer_median(&timer);
+    result->calibration_seconds = bench_timer_median(&calibration);
+    result->peak_rss_kb = bench_peak_rss_kb();
+}
+
+// Each phase runs in its own process so its peak RSS is its own
+static bool measure(const Shape* shape, Phase phase, size_t size, int runs, BenchResult* result) {
+    int fds[2];
+    if (pipe(fds) != 0) return false;
+
+    pid_t pid = fork();
+    if (pid == 0) {
+        close(fds[0]);
+        // Lexical errors would flood the terminal; the ok flag reports them
+        if (!freopen("/dev/null", "w", stderr)) _exit(1);
+
+        char* source = generate_corpus(shape, size);
+        memset(result, 0, sizeof(*result));
+        snprintf(result->shape, sizeof(result->shape), "%s", shape->name);
+        snprintf(result->phase, sizeof(result->phase), "%s", PHASE_NAMES[phase]);
+        snprintf(result->unit, sizeof(result->unit), "%s", PHASE_UNITS[phase]);
+        result->input_bytes = (long)strlen(source);
+        run_phase(shape, phase, source, runs, result);
+
+        ssize_t written = write(fds[1], result, sizeof(*result));
+        _exit(written == (ssize_t)sizeof(*result) ? 0 : 1);
+    }
+
+    close(fds[1]);
+    ssize_t got = pid > 0 ? read(fds[0], result, sizeof(*result)) : -1;
+    close(fds[0]);
+
+    int status = 0;
+    if (pid > 0) waitpid(pid, &status, 0);
+    return got == (ssize_t)sizeof(*result) && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+// ============================================================================
+// REPORTING
+// ============================================================================
+
+static double items_per_sec(const BenchResult* result) {
+    return result->seconds > 0 ? result->items / result->seconds : 0.0;
+}
+
+static double mb_per_sec(const BenchResult* result) {
+    return result->seconds > 0 ? result->input_bytes / result->seconds / (1024.0 * 1024.0) : 0.0;
+}
+
+static double calibration_mb_per_sec(const BenchResult* result) {
+    return result->calibration_seconds > 0
+               ? result->input_bytes / result->calibration_seconds / (1024.0 * 1024.0) : 0.0;
+}
+
+static bool write_json(const char* path, const BenchResult* results, int count, int size_mb) {
+    FILE* out = fopen(path, "w");
+    if (!out) {
+        fprintf(stderr, "Could not create %s\n", path);
+        return false;
+    }
+
+    // One result per line so the baseline reader can stay line-based
+    fprintf(out, "{\n  \"size_mb\": %d,\n  \"simd\": \"%s\",\n  \"results\": [\n",
+            size_mb, scan_implementation());
+    for (int i = 0; i < count; i++) {
+        const BenchResult* r = &results[i];
+        fprintf(out,
+                "    {\"shape\": \"%s\", \"phase\": \"%s\", \"unit\": \"%s\", \"ok\": %s, "
+                "\"input_bytes\": %ld, \"items\": %ld, \"seconds\": %.6f, "
+                "\"items_per_sec\": %.0f, \"input_mb_per_sec\": %.1f, \"calibration_mb_per_sec\": %.1f, "
+                "\"peak_rss_kb\": %ld}%s\n",
+                r->shape, r->phase, r->unit, r->ok ? "true" : "false",
+                r->input_bytes, r->items, r->seconds,
+                items_per_sec(r), mb_per_sec(r), calibration_mb_per_sec(r), r->peak_rss_kb,
+                i + 1 < count ? "," : "");
+    }
+    fprintf(out, "  ]\n}\n");
+    fclose(out);
+    return true;
+}
+
+static bool json_string(const char* line, const char* key, char* buffer, size_t size) {
+    char pattern[64];
+    snprintf(pattern, sizeof(pattern), "\"%s\": \"", key);
+    const char* p = strstr(line, pattern);
+    if (!p) return false;
+    p += strlen(pattern);
+    size_t len = strcspn(p, "\"");
+    if (len >= size) len = size - 1;
+    memcpy(buffer, p, len);
+    buffer[len] = '\0';
+    return true;
+}
+
+static bool json_number(const char* line, const char* key, double* value) {
+    char pattern[64];
+    snprintf(pattern, sizeof(pattern), "\"%s\": ", key);
+    const char* p = strstr(line, pattern);
+    return p && sscanf(p + strlen(pattern), "%lf", value) == 1;
+}
+
+// Returns the number of regressions, or -1 when there is no baseline. Token,
+// node and byte counts depend only on the corpus and the compiler, so any
+// change in one is a regression. Rates are compared as multiples of the
+// calibration rate measured alongside them; that takes out the host but not
+// its noise, so a drop past the tolerance is only flagged
+static int compare_baseline(const char* path, const BenchResult* results, int count, double tolerance) {
+    FILE* in = fopen(path, "r");
+    if (!in) return -1;
+
+    printf("\nAgainst baseline %s (rates relative to calibration, flagged past -%.0f%%):\n",
+           path, tolerance * 100);
+
+    int regressions = 0;
+    char line[1024];
+    while (fgets(line, sizeof(line), in)) {
+        char shape[32], phase[8];
+        double baseline_rate, baseline_items;
+        double baseline_calibration = 0.0;
+        json_number(line, "calibration_mb_per_sec", &baseline_calibration);
+        if (!json_string(line, "shape", shape, sizeof(shape)) ||
+            !json_string(line, "phase", phase, sizeof(phase)) ||
+            !json_number(line, "items", &baseline_items) ||
+            !json_number(line, "items_per_sec", &baseline_rate) || baseline_rate <= 0) {
+            continue;
+        }
+
+        for (int i = 0; i < count; i++) {
+            const BenchResult* r = &results[i];
+            if (strcmp(r->shape, shape) != 0 || strcmp(r->phase, phase) != 0) continue;
+
+            double calibration = calibration_mb_per_sec(r);
+            bool calibrated = baseline_calibration > 0 && calibration > 0;
+            double change = calibrated ? (items_per_sec(r) / calibration) /
+                                         (baseline_rate / baseline_calibration) - 1.0 : 0.0;
+            bool recount = r->items != (long)baseline_items;
+            bool regressed = !r->ok || recount;
+            regressions += regressed;
+            if (calibrated) {
+                printf("  %-12s %-5s %+7.1f%%  ", shape, phase, change * 100);
+            } else {
+                printf("  %-12s %-5s %8s  ", shape, phase, "n/a");
+            }
+            if (recount) {
+                printf("✗ %ld %s, baseline has %.0f\n", r->items, r->unit, baseline_items);
+            } else if (regressed) {
+                printf("✗ errors\n");
+            } else {
+                printf("%s\n", change < -tolerance ? "⚠ slower" : "✓");
+            }
+        }
+    }
+
+    fclose(in);
+    return regressions;
+}
+
+// ============================================================================
+// MAIN
+// ============================================================================
+
+static void usage(const char* program) {
+    fprintf(stderr, "Usage: %s [--size MB] [--runs N] [--json FILE] [--baseline FILE] [--tolerance F] [--jobs N]\n", program);
+}
+
+int main(int argc, char** argv) {
+    int size_mb = DEFAULT_SIZE_MB;
+    int runs = DEFAULT_RUNS;
+    double tolerance = DEFAULT_TOLERANCE;
+    const char* json_path = NULL;
+    const char* baseline_path = NULL;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--size") == 0 && i + 1 < argc) {
+            size_mb = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--runs") == 0 && i + 1 < argc) {
+            runs = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--json") == 0 && i + 1 < argc) {
+            json_path = argv[++i];
+        } else if (strcmp(argv[i], "--baseline") == 0 && i + 1 < argc) {
+            baseline_path = argv[++i];
+        } else if (strcmp(argv[i], "--tolerance") == 0 && i + 1 < argc) {
+            tolerance = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--jobs") == 0 && i + 1 < argc) {
+            parse_jobs = atoi(argv[++i]);
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (size_mb < 1 || runs < 1 || runs > BENCH_MAX_RUNS || parse_jobs < 1) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    size_t size = (size_t)size_mb * 1024 * 1024;
+    BenchResult results[MAX_RESULTS];
+    int count = 0;
+    bool failed = false;
+
+    printf("So Lang Benchmark Suite (%d MB per shape, median of %d, %s scanners)\n",
+           size_mb, runs, scan_implementation());
+    printf("  %-12s %-5s %12s %14s %10s %12s\n",
+           "shape", "phase", "items", "items/s", "MB/s", "peak RSS");
+
+    for (int s = 0; s < SHAPE_COUNT; s++) {
+        const Shape* shape = &SHAPES[s];
+        for (Phase phase = PHASE_LEX; phase <= PHASE_EMIT; phase++) {
+            BenchResult* r = &results[count];
+            if (!measure(shape, phase, size, runs, r)) {
+                fprintf(stderr, "  %-12s %-5s measurement failed\n", shape->name, PHASE_NAMES[phase]);
+                failed = true;
+                continue;
+            }
+            count++;
+
+            printf("  %-12s %-5s %12ld %12.2f M %10.1f %9ld KB%s\n",
+                   r->shape, r->phase, r->items, items_per_sec(r) / 1e6,
+                   mb_per_sec(r), r->peak_rss_kb, r->ok ? "" : "  (errors)");
+            failed |= !r->ok;
+        }
+    }
+
+    if (json_path && write_json(json_path, results, count, size_mb)) {
+        printf("\nResults written to %s\n", json_path);
+    }
+
+    if (baseline_path) {
+        int regressions = compare_baseline(baseline_path, results, count, tolerance);
+        if (regressions < 0) {
+            printf("\nNo baseline at %s; run 'make bench-baseline' to record one\n", baseline_path);
+        } else if (regressions > 0) {
+            printf("✗ %d regression(s) against baseline\n", regressions);
+            failed = true;
+        } else {
+            printf("✓ No regressions against baseline\n");
+        }
+    }
+
+    return failed ? 1 : 0;
+}
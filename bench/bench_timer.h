@@ -0,0 +1,59 @@
+/*
+ * bench_timer.h - Timing and Memory Helpers for the Benchmark Suite
+ * Monotonic wall clock, median-of-N timing and peak resident set size
+ */
+
+#ifndef BENCH_TIMER_H
+#define BENCH_TIMER_H
+
+#include <sys/resource.h>
+#include <time.h>
+
+static inline double bench_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+// High-water resident set size of this process in KB
+static inline long bench_peak_rss_kb(void) {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+#define BENCH_MAX_RUNS 64
+
+// Keeps every run and reports the median: one lucky run can not make a
+// phase look faster than it is, and one slow one can not hide a gain
+typedef struct {
+    double start;
+    double samples[BENCH_MAX_RUNS];
+    int runs;
+} BenchTimer;
+
+static inline void bench_timer_start(BenchTimer* timer) {
+    timer->start = bench_now();
+}
+
+static inline void bench_timer_stop(BenchTimer* timer) {
+    if (timer->runs < BENCH_MAX_RUNS) timer->samples[timer->runs++] = bench_now() - timer->start;
+}
+
+static inline double bench_timer_median(BenchTimer* timer) {
+    if (timer->runs == 0) return 0.0;
+
+    // Insertion sort; there are only a handful of runs
+    for (int i = 1; i < timer->runs; i++) {
+        double sample = timer->samples[i];
+        int j = i;
+        for (; j > 0 && timer->samples[j - 1] > sample; j--) timer->samples[j] = timer->samples[j - 1];
+        timer->samples[j] = sample;
+    }
+
+    int middle = timer->runs / 2;
+    return timer->runs % 2 ? timer->samples[middle]
+                           : (timer->samples[middle - 1] + timer->samples[middle]) / 2.0;
+}
+
+#endif
@@ -0,0 +1,105 @@
+/*
+ * keyword_bench.c - Identifier Classification Microbenchmark
+ * Compares the old strcmp keyword chain against the perfect-hash table
+ */
+
+#define _POSIX_C_SOURCE 199309L
+
+#include <time.h>
+
+#include "../src/so_lang.h"
+#include "../src/so_lang_keywords.h"
+
+#define ROUNDS 2000000
+
+// Identifier mix taken from the Solana examples: mostly plain names
+static const char* const IDENTIFIERS[] = {
+    "counter", "count", "user", "escrow", "sender", "recipient", "amount",
+    "mint", "vault", "vault_authority", "token_program", "expires_at",
+    "instruction", "account", "require", "let", "if", "print", "state",
+    "signer", "writable", "init", "seeds", "bump", "emit", "pubkey",
+    "proposal", "votes_for", "votes_against", "voter", "clock", "key",
+};
+
+// Classification as the lexers did it before the keyword table
+static TokenType classify_strcmp(const char* buffer) {
+    TokenType type = TOKEN_IDENTIFIER;
+    if (strcmp(buffer, "let") == 0) type = TOKEN_LET;
+    else if (strcmp(buffer, "fn") == 0) type = TOKEN_FN;
+    else if (strcmp(buffer, "if") == 0) type = TOKEN_IF;
+    else if (strcmp(buffer, "else") == 0) type = TOKEN_ELSE;
+    else if (strcmp(buffer, "return") == 0) type = TOKEN_RETURN;
+    else if (strcmp(buffer, "print") == 0) type = TOKEN_PRINT;
+    else if (strcmp(buffer, "program") == 0) type = TOKEN_PROGRAM;
+    else if (strcmp(buffer, "instruction") == 0) type = TOKEN_INSTRUCTION;
+    else if (strcmp(buffer, "account") == 0) type = TOKEN_ACCOUNT;
+    else if (strcmp(buffer, "state") == 0) type = TOKEN_STATE;
+    else if (strcmp(buffer, "pubkey") == 0) type = TOKEN_PUBKEY;
+    else if (strcmp(buffer, "lamports") == 0) type = TOKEN_LAMPORTS;
+    else if (strcmp(buffer, "signer") == 0) type = TOKEN_SIGNER;
+    else if (strcmp(buffer, "writable") == 0) type = TOKEN_WRITABLE;
+    else if (strcmp(buffer, "init") == 0) type = TOKEN_INIT;
+    else if (strcmp(buffer, "seeds") == 0) type = TOKEN_SEEDS;
+    else if (strcmp(buffer, "bump") == 0) type = TOKEN_BUMP;
+    else if (strcmp(buffer, "pda") == 0) type = TOKEN_PDA;
+    else if (strcmp(buffer, "transfer") == 0) type = TOKEN_TRANSFER;
+    else if (strcmp(buffer, "invoke") == 0) type = TOKEN_INVOKE;
+    else if (strcmp(buffer, "require") == 0) type = TOKEN_REQUIRE;
+    else if (strcmp(buffer, "error") == 0) type = TOKEN_ERROR;
+    else if (strcmp(buffer, "event") == 0) type = TOKEN_EVENT;
+    else if (strcmp(buffer, "emit") == 0) type = TOKEN_EMIT;
+    else if (strcmp(buffer, "anchor") == 0) type = TOKEN_ANCHOR;
+    else if (strcmp(buffer, "solana") == 0) type = TOKEN_SOLANA;
+    else if (strcmp(buffer, "entrypoint") == 0) type = TOKEN_ENTRYPOINT;
+    return type;
+}
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+int main(void) {
+    const int count = sizeof(IDENTIFIERS) / sizeof(IDENTIFIERS[0]);
+    const unsigned sets = KEYWORD_CORE | KEYWORD_SOLANA | KEYWORD_SOLANA_EXT;
+    int lengths[sizeof(IDENTIFIERS) / sizeof(IDENTIFIERS[0])];
+    long checksum_before = 0;
+    long checksum_after = 0;
+
+    for (int i = 0; i < count; i++) {
+        lengths[i] = (int)strlen(IDENTIFIERS[i]);
+        if (classify_strcmp(IDENTIFIERS[i]) !=
+            keyword_lookup(IDENTIFIERS[i], lengths[i], sets)) {
+            fprintf(stderr, "✗ Classification mismatch for '%s'\n", IDENTIFIERS[i]);
+            return 1;
+        }
+    }
+
+    // Identifiers are copied into a token buffer first, as the old lexers did
+    char buffer[MAX_TOKEN_LEN];
+    double start = now_seconds();
+    for (int round = 0; round < ROUNDS; round++) {
+        for (int i = 0; i < count; i++) {
+            memcpy(buffer, IDENTIFIERS[i], lengths[i] + 1);
+            checksum_before += classify_strcmp(buffer);
+        }
+    }
+    double before = now_seconds() - start;
+
+    start = now_seconds();
+    for (int round = 0; round < ROUNDS; round++) {
+        for (int i = 0; i < count; i++) {
+            checksum_after += keyword_lookup(IDENTIFIERS[i], lengths[i], sets);
+        }
+    }
+    double after = now_seconds() - start;
+
+    double total = (double)ROUNDS * count / 1e6;
+    printf("So Lang Keyword Classification Benchmark\n");
+    printf("  strcmp chain: %8.1f M identifiers/s\n", total / before);
+    printf("  hash table:   %8.1f M identifiers/s\n", total / after);
+    printf("  speedup:      %8.1fx\n", before / after);
+
+    return checksum_before == checksum_after ? 0 : 1;
+}
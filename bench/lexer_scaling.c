@@ -0,0 +1,104 @@
+/*
+ * lexer_scaling.c - Lexer Scaling Regression Benchmark
+ * Lexes 1 MB, 10 MB and 100 MB inputs and fails if time grows faster than linear
+ */
+
+#define _DEFAULT_SOURCE
+
+#include <time.h>
+
+// Pull in the bootstrap compiler (error() and friends); its main() is renamed out of the way
+#define main solang_enhanced_main
+#include "../src/so_lang_enhanced.c"
+#undef main
+
+#define MB (1024L * 1024L)
+
+// Allowed slack over perfectly linear growth between consecutive sizes
+#define MAX_SCALING_RATIO 2.0
+
+// Statement shapes repeated to fill each input
+static const char* const CORPUS_LINES[] = {
+    "let counter_value = counter_value + 1\n",
+    "    if balance == 1000 {\n",
+    "        print(\"transfer complete\")\n",
+    "    }\n",
+    "// bookkeeping for the next round\n",
+    "fn settle_escrow() {\n",
+    "    return amount * 3 / 2 - fee\n",
+    "}\n",
+};
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static char* generate_source(long size) {
+    const int line_count = sizeof(CORPUS_LINES) / sizeof(CORPUS_LINES[0]);
+    char* source = malloc(size + 1);
+    long pos = 0;
+    int i = 0;
+
+    for (;;) {
+        const char* line = CORPUS_LINES[i++ % line_count];
+        long len = (long)strlen(line);
+        if (pos + len > size) break;
+        memcpy(source + pos, line, len);
+        pos += len;
+    }
+    memset(source + pos, ' ', size - pos);
+    source[size] = '\0';
+    return source;
+}
+
+static double time_lexer(long size, int* token_count) {
+    char* source = generate_source(size);
+    double best = 0.0;
+
+    for (int run = 0; run < 3; run++) {
+        Lexer* lexer = lexer_create(source, LEXER_DIALECT_CORE);
+        double start = now_seconds();
+        lexer_tokenize(lexer);
+        double elapsed = now_seconds() - start;
+        if (run == 0 || elapsed < best) best = elapsed;
+        *token_count = lexer->token_count;
+        lexer_free(lexer);
+    }
+
+    free(source);
+    return best;
+}
+
+int main(void) {
+    const long sizes[] = {1 * MB, 10 * MB, 100 * MB};
+    const int count = sizeof(sizes) / sizeof(sizes[0]);
+    double times[3];
+    bool linear = true;
+
+    printf("So Lang Lexer Scaling Benchmark\n");
+
+    for (int i = 0; i < count; i++) {
+        int tokens = 0;
+        times[i] = time_lexer(sizes[i], &tokens);
+        printf("  %4ld MB: %8.3f ms  %9d tokens  (%7.1f MB/s)\n",
+               sizes[i] / MB, times[i] * 1000.0, tokens,
+               (double)sizes[i] / MB / times[i]);
+    }
+
+    for (int i = 1; i < count; i++) {
+        double expected = (double)sizes[i] / sizes[i - 1];
+        double ratio = times[i] / times[i - 1];
+        if (ratio > expected * MAX_SCALING_RATIO) {
+            fprintf(stderr, "✗ %ld MB -> %ld MB took %.1fx longer (expected ~%.0fx)\n",
+                    sizes[i - 1] / MB, sizes[i] / MB, ratio, expected);
+            linear = false;
+        }
+    }
+
+    if (!linear) return 1;
+
+    printf("✓ Lexer scales linearly\n");
+    return 0;
+}
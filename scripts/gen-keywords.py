@@ -0,0 +1,125 @@
+#!/usr/bin/env python3
+# gen-keywords.py - Generate the So Lang perfect-hash keyword table
+# Location: scripts/gen-keywords.py
+# Writes src/so_lang_keywords.h; rerun after adding or removing a keyword
+
+import itertools
+import os
+import sys
+
+SCRIPT_DIR = os.path.dirname(os.path.abspath(__file__))
+OUTPUT = os.path.join(os.path.dirname(SCRIPT_DIR), "src", "so_lang_keywords.h")
+
+TABLE_BITS = 6
+
+# (keyword, token, dialects)
+KEYWORDS = [
+    ("let",         "TOKEN_LET",         ["CORE"]),
+    ("fn",          "TOKEN_FN",          ["CORE"]),
+    ("if",          "TOKEN_IF",          ["CORE"]),
+    ("else",        "TOKEN_ELSE",        ["CORE"]),
+    ("return",      "TOKEN_RETURN",      ["CORE"]),
+    ("print",       "TOKEN_PRINT",       ["CORE"]),
+    ("program",     "TOKEN_PROGRAM",     ["SOLANA", "ATTRIBUTE"]),
+    ("instruction", "TOKEN_INSTRUCTION", ["SOLANA", "ATTRIBUTE"]),
+    ("account",     "TOKEN_ACCOUNT",     ["SOLANA", "ATTRIBUTE"]),
+    ("state",       "TOKEN_STATE",       ["SOLANA"]),
+    ("pubkey",      "TOKEN_PUBKEY",      ["SOLANA"]),
+    ("signer",      "TOKEN_SIGNER",      ["SOLANA", "ATTRIBUTE"]),
+    ("writable",    "TOKEN_WRITABLE",    ["SOLANA", "ATTRIBUTE"]),
+    ("init",        "TOKEN_INIT",        ["SOLANA", "ATTRIBUTE"]),
+    ("seeds",       "TOKEN_SEEDS",       ["SOLANA"]),
+    ("bump",        "TOKEN_BUMP",        ["SOLANA"]),
+    ("transfer",    "TOKEN_TRANSFER",    ["SOLANA"]),
+    ("require",     "TOKEN_REQUIRE",     ["SOLANA"]),
+    ("emit",        "TOKEN_EMIT",        ["SOLANA"]),
+    ("lamports",    "TOKEN_LAMPORTS",    ["SOLANA_EXT"]),
+    ("pda",         "TOKEN_PDA",         ["SOLANA_EXT"]),
+    ("invoke",      "TOKEN_INVOKE",      ["SOLANA_EXT"]),
+    ("error",       "TOKEN_ERROR",       ["SOLANA_EXT"]),
+    ("event",       "TOKEN_EVENT",       ["SOLANA_EXT"]),
+    ("anchor",      "TOKEN_ANCHOR",      ["SOLANA_EXT"]),
+    ("solana",      "TOKEN_SOLANA",      ["SOLANA_EXT"]),
+    ("entrypoint",  "TOKEN_ENTRYPOINT",  ["SOLANA_EXT"]),
+]
+
+
+def keyword_hash(word, a, b):
+    # Must match KEYWORD_HASH in the generated header
+    mask = (1 << TABLE_BITS) - 1
+    return (ord(word[0]) * a + ord(word[-1]) * b + len(word)) & mask
+
+
+def find_constants():
+    for a, b in itertools.product(range(1, 64), repeat=2):
+        slots = {keyword_hash(word, a, b) for word, _, _ in KEYWORDS}
+        if len(slots) == len(KEYWORDS):
+            return a, b
+    sys.exit("gen-keywords: no collision-free constants; raise TABLE_BITS")
+
+
+def main():
+    a, b = find_constants()
+    size = 1 << TABLE_BITS
+    entries = sorted((keyword_hash(w, a, b), w, t, d) for w, t, d in KEYWORDS)
+    lengths = [len(w) for w, _, _ in KEYWORDS]
+
+    out = []
+    out.append("/*")
+    out.append(" * so_lang_keywords.h - So Lang Keyword Table")
+    out.append(" * Generated by scripts/gen-keywords.py - do not edit by hand")
+    out.append(" */")
+    out.append("")
+    out.append("#ifndef SO_LANG_KEYWORDS_H")
+    out.append("#define SO_LANG_KEYWORDS_H")
+    out.append("")
+    out.append('#include "so_lang.h"')
+    out.append("")
+    out.append("// Keyword sets; each lexer passes the sets its dialect recognizes")
+    out.append("#define KEYWORD_CORE       0x1")
+    out.append("#define KEYWORD_SOLANA     0x2")
+    out.append("#define KEYWORD_SOLANA_EXT 0x4")
+    out.append("#define KEYWORD_ATTRIBUTE  0x8")
+    out.append("")
+    out.append("#define KEYWORD_MIN_LEN %d" % min(lengths))
+    out.append("#define KEYWORD_MAX_LEN %d" % max(lengths))
+    out.append("#define KEYWORD_TABLE_SIZE %d" % size)
+    out.append("")
+    out.append("// Collision-free over every keyword, so a lookup is one probe and one memcmp")
+    out.append("#define KEYWORD_HASH(text, length) \\")
+    out.append("    (((unsigned char)(text)[0] * %du + \\" % a)
+    out.append("      (unsigned char)(text)[(length) - 1] * %du + \\" % b)
+    out.append("      (unsigned)(length)) & (KEYWORD_TABLE_SIZE - 1))")
+    out.append("")
+    out.append("typedef struct {")
+    out.append("    const char* name;")
+    out.append("    unsigned char length;")
+    out.append("    unsigned char sets;")
+    out.append("    TokenType type;")
+    out.append("} Keyword;")
+    out.append("")
+    out.append("static const Keyword KEYWORD_TABLE[KEYWORD_TABLE_SIZE] = {")
+    for slot, word, token, sets in entries:
+        mask = " | ".join("KEYWORD_" + s for s in sets)
+        out.append('    [%2d] = {"%s", %d, %s, %s},' % (slot, word, len(word), mask, token))
+    out.append("};")
+    out.append("")
+    out.append("static inline TokenType keyword_lookup(const char* text, int length, unsigned sets) {")
+    out.append("    if (length < KEYWORD_MIN_LEN || length > KEYWORD_MAX_LEN) return TOKEN_IDENTIFIER;")
+    out.append("    const Keyword* keyword = &KEYWORD_TABLE[KEYWORD_HASH(text, length)];")
+    out.append("    if (keyword->length == length && (keyword->sets & sets) &&")
+    out.append("        memcmp(keyword->name, text, length) == 0) {")
+    out.append("        return keyword->type;")
+    out.append("    }")
+    out.append("    return TOKEN_IDENTIFIER;")
+    out.append("}")
+    out.append("")
+    out.append("#endif")
+
+    with open(OUTPUT, "w") as f:
+        f.write("\n".join(out) + "\n")
+    print("Generated %s (%d keywords, %d slots)" % (OUTPUT, len(KEYWORDS), size))
+
+
+if __name__ == "__main__":
+    main()
@@ -4,71 +4,27 @@
  */
 
 #include "so_lang.h"
-
-static bool has_error = false;
-
-static bool detected_solana = false;
-static char* detected_program_name = NULL;
-
-// ============================================================================
-// UTILITY FUNCTIONS
-// ============================================================================
-
-void error(const char* message, int line, int column) {
-    fprintf(stderr, "Error at line %d, column %d: %s\n", line, column, message);
-    has_error = true;
-}
-
-char* read_file(const char* filename) {
-    FILE* file = fopen(filename, "r");
-    if (!file) {
-        fprintf(stderr, "Could not open file: %s\n", filename);
-        return NULL;
-    }
-    
-    fseek(file, 0, SEEK_END);
-    long size = ftell(file);
-    fseek(file, 0, SEEK_SET);
-    
-    char* content = malloc(size + 1);
-    fread(content, 1, size, file);
-    content[size] = '\0';
-    
-    fclose(file);
-    return content;
-}
+#include "so_lang_solana.h"
 
 // ============================================================================
 // SOLANA PROGRAM ID GENERATION AND DETECTION
 // ============================================================================
 
-bool detect_solana_program(ASTNode* ast) {
-    if (!ast) return false;
-    
-    if (ast->type == NODE_PROGRAM_DECL) {
-        detected_solana = true;
-        if (detected_program_name) free(detected_program_name);
-        detected_program_name = malloc(strlen(ast->value) + 1);
-        strcpy(detected_program_name, ast->value);
-        return true;
-    }
-    
-    if (ast->type == NODE_INSTRUCTION_DECL || 
-        ast->type == NODE_ACCOUNT_CONSTRAINT ||
-        ast->type == NODE_TRANSFER_STMT ||
-        ast->type == NODE_REQUIRE_STMT ||
-        ast->type == NODE_EMIT_STMT) {
-        detected_solana = true;
-        return true;
-    }
-    
-    for (int i = 0; i < ast->child_count; i++) {
-        if (detect_solana_program(ast->children[i])) {
-            return true;
-        }
+// A Solana source is a program and the types around it, so it opens with a
+// declaration keyword once comments and blank lines are skipped; anything
+// else is a core program
+bool detect_solana_program(char* source) {
+    Lexer* lexer = lexer_create(source, LEXER_DIALECT_SOLANA);
+    Token* token = lexer_peek(lexer, 0);
+    while (token->type == TOKEN_NEWLINE) {
+        lexer_next_token(lexer);
+        token = lexer_peek(lexer, 0);
     }
     
-    return false;
+    bool found = token->type == TOKEN_PROGRAM || token->type == TOKEN_STATE ||
+                 token->type == TOKEN_EVENT || token->type == TOKEN_ERROR;
+    lexer_free(lexer);
+    return found;
 }
 
 char* generate_program_id(const char* program_name) {
@@ -147,768 +103,314 @@ void validate_program_id(const char* program_id) {
 }
 
 // ============================================================================
-// LEXER IMPLEMENTATION
+// MAIN FUNCTION
 // ============================================================================
 
-Lexer* lexer_create(char* source) {
-    Lexer* lexer = malloc(sizeof(Lexer));
-    lexer->source = source;
-    lexer->pos = 0;
-    lexer->line = 1;
-    lexer->column = 1;
-    lexer->token_count = 0;
-    return lexer;
-}
-
-static char lexer_current_char(Lexer* lexer) {
-    if (lexer->pos >= strlen(lexer->source)) return '\0';
-    return lexer->source[lexer->pos];
-}
-
-static char lexer_advance(Lexer* lexer) {
-    char c = lexer_current_char(lexer);
-    lexer->pos++;
-    if (c == '\n') {
-        lexer->line++;
-        lexer->column = 1;
-    } else {
-        lexer->column++;
-    }
-    return c;
-}
-
-static void lexer_skip_whitespace(Lexer* lexer) {
-    while (isspace(lexer_current_char(lexer)) && lexer_current_char(lexer) != '\n') {
-        lexer_advance(lexer);
-    }
-}
-
-static void lexer_add_token(Lexer* lexer, TokenType type, const char* value) {
-    if (lexer->token_count >= MAX_TOKENS) {
-        error("Too many tokens", lexer->line, lexer->column);
-        return;
-    }
-    
-    Token* token = &lexer->tokens[lexer->token_count++];
-    token->type = type;
-    strncpy(token->value, value, MAX_TOKEN_LEN - 1);
-    token->value[MAX_TOKEN_LEN - 1] = '\0';
-    token->line = lexer->line;
-    token->column = lexer->column;
-}
-
-static void lexer_read_string(Lexer* lexer) {
-    char buffer[MAX_TOKEN_LEN];
-    int i = 0;
-    
-    lexer_advance(lexer); // Skip opening quote
-    
-    while (lexer_current_char(lexer) != '"' && lexer_current_char(lexer) != '\0') {
-        if (i < MAX_TOKEN_LEN - 1) {
-            buffer[i++] = lexer_current_char(lexer);
-        }
-        lexer_advance(lexer);
-    }
-    
-    if (lexer_current_char(lexer) == '"') {
-        lexer_advance(lexer); // Skip closing quote
-    }
-    
-    buffer[i] = '\0';
-    lexer_add_token(lexer, TOKEN_STRING, buffer);
-}
-
-static void lexer_read_identifier(Lexer* lexer) {
-    char buffer[MAX_TOKEN_LEN];
-    int i = 0;
-    
-    while (isalnum(lexer_current_char(lexer)) || lexer_current_char(lexer) == '_') {
-        if (i < MAX_TOKEN_LEN - 1) {
-            buffer[i++] = lexer_current_char(lexer);
+// What each --targets name selects; the same as its single-target flag.
+// Solana targets run the Solana frontend, the others the core one
+typedef struct {
+    const char* name;
+    const char* extension;
+    const char* default_file;
+    bool solana;
+    bool use_anchor;
+} TargetSpec;
+
+enum { TARGET_C, TARGET_RUST, TARGET_ANCHOR, TARGET_NATIVE };
+
+static const TargetSpec target_specs[] = {
+    [TARGET_C]      = {"c",      "c",  "output.c",   false, false},
+    [TARGET_RUST]   = {"rust",   "rs", "output.rs",  false, false},
+    [TARGET_ANCHOR] = {"anchor", "rs", "lib.rs",     true,  true},
+    [TARGET_NATIVE] = {"native", "rs", "program.rs", true,  false},
+};
+
+#define TARGET_COUNT ((int)(sizeof(target_specs) / sizeof(target_specs[0])))
+
+// One backend run over the shared tree, into a file of its own
+typedef struct {
+    const TargetSpec* spec;
+    char output_file[512];
+    FILE* output_fp;
+    Compiler* compiler;         // Core targets
+    SolanaCompiler* solana;     // Solana targets
+    bool written;
+} TargetJob;
+
+typedef struct {
+    TargetJob* jobs;
+    ASTNode* ast;
+} TargetRun;
+
+// A bit per entry of target_specs; 0 if a name is not a target
+static unsigned parse_targets(const char* list) {
+    unsigned selected = 0;
+    
+    while (*list) {
+        size_t length = strcspn(list, ",");
+        int i = 0;
+        while (i < TARGET_COUNT && (strlen(target_specs[i].name) != length ||
+                                    memcmp(target_specs[i].name, list, length) != 0)) {
+            i++;
         }
-        lexer_advance(lexer);
-    }
-    
-    buffer[i] = '\0';
-    
-    TokenType type = TOKEN_IDENTIFIER;
-    if (strcmp(buffer, "let") == 0) type = TOKEN_LET;
-    else if (strcmp(buffer, "fn") == 0) type = TOKEN_FN;
-    else if (strcmp(buffer, "if") == 0) type = TOKEN_IF;
-    else if (strcmp(buffer, "else") == 0) type = TOKEN_ELSE;
-    else if (strcmp(buffer, "return") == 0) type = TOKEN_RETURN;
-    else if (strcmp(buffer, "print") == 0) type = TOKEN_PRINT;
-    else if (strcmp(buffer, "program") == 0) type = TOKEN_PROGRAM;
-    else if (strcmp(buffer, "instruction") == 0) type = TOKEN_INSTRUCTION;
-    else if (strcmp(buffer, "account") == 0) type = TOKEN_ACCOUNT;
-    else if (strcmp(buffer, "state") == 0) type = TOKEN_STATE;
-    else if (strcmp(buffer, "pubkey") == 0) type = TOKEN_PUBKEY;
-    else if (strcmp(buffer, "signer") == 0) type = TOKEN_SIGNER;
-    else if (strcmp(buffer, "writable") == 0) type = TOKEN_WRITABLE;
-    else if (strcmp(buffer, "init") == 0) type = TOKEN_INIT;
-    else if (strcmp(buffer, "seeds") == 0) type = TOKEN_SEEDS;
-    else if (strcmp(buffer, "bump") == 0) type = TOKEN_BUMP;
-    else if (strcmp(buffer, "transfer") == 0) type = TOKEN_TRANSFER;
-    else if (strcmp(buffer, "require") == 0) type = TOKEN_REQUIRE;
-    else if (strcmp(buffer, "emit") == 0) type = TOKEN_EMIT;
-    
-    lexer_add_token(lexer, type, buffer);
-}
-
-static void lexer_read_number(Lexer* lexer) {
-    char buffer[MAX_TOKEN_LEN];
-    int i = 0;
-    
-    while (isdigit(lexer_current_char(lexer)) || lexer_current_char(lexer) == '.') {
-        if (i < MAX_TOKEN_LEN - 1) {
-            buffer[i++] = lexer_current_char(lexer);
+        if (i == TARGET_COUNT) {
+            fprintf(stderr, "Unknown target: %.*s (expected c, rust, anchor or native)\n", (int)length, list);
+            return 0;
         }
-        lexer_advance(lexer);
-    }
-    
-    buffer[i] = '\0';
-    lexer_add_token(lexer, TOKEN_NUMBER, buffer);
-}
-
-void lexer_tokenize(Lexer* lexer) {
-    while (lexer_current_char(lexer) != '\0') {
-        char c = lexer_current_char(lexer);
+        selected |= 1u << i;
         
-        if (isspace(c) && c != '\n') {
-            lexer_skip_whitespace(lexer);
-        } else if (c == '\n') {
-            lexer_add_token(lexer, TOKEN_NEWLINE, "\n");
-            lexer_advance(lexer);
-        } else if (c == '"') {
-            lexer_read_string(lexer);
-        } else if (isalpha(c) || c == '_') {
-            lexer_read_identifier(lexer);
-        } else if (isdigit(c)) {
-            lexer_read_number(lexer);
-        } else {
-            char token_str[2] = {c, '\0'};
-            switch (c) {
-                case '=':
-                    if (lexer->source[lexer->pos + 1] == '=') {
-                        lexer_advance(lexer);
-                        lexer_add_token(lexer, TOKEN_EQUAL, "==");
-                    } else {
-                        lexer_add_token(lexer, TOKEN_ASSIGN, "=");
-                    }
-                    break;
-                case '+': lexer_add_token(lexer, TOKEN_PLUS, token_str); break;
-                case '-': lexer_add_token(lexer, TOKEN_MINUS, token_str); break;
-                case '*': lexer_add_token(lexer, TOKEN_MULTIPLY, token_str); break;
-                case '/': lexer_add_token(lexer, TOKEN_DIVIDE, token_str); break;
-                case '<': lexer_add_token(lexer, TOKEN_LESS, token_str); break;
-                case '>': lexer_add_token(lexer, TOKEN_GREATER, token_str); break;
-                case '(': lexer_add_token(lexer, TOKEN_LPAREN, token_str); break;
-                case ')': lexer_add_token(lexer, TOKEN_RPAREN, token_str); break;
-                case '{': lexer_add_token(lexer, TOKEN_LBRACE, token_str); break;
-                case '}': lexer_add_token(lexer, TOKEN_RBRACE, token_str); break;
-                case ',': lexer_add_token(lexer, TOKEN_COMMA, token_str); break;
-                case ';': lexer_add_token(lexer, TOKEN_SEMICOLON, token_str); break;
-                case '@': lexer_add_token(lexer, TOKEN_AT_SYMBOL, token_str); break;
-                default:
-                    error("Unexpected character", lexer->line, lexer->column);
-                    break;
-            }
-            lexer_advance(lexer);
-        }
-    }
-    
-    lexer_add_token(lexer, TOKEN_EOF, "");
-}
-
-void lexer_free(Lexer* lexer) {
-    free(lexer);
-}
-
-// ============================================================================
-// AST IMPLEMENTATION
-// ============================================================================
-
-ASTNode* ast_create_node(NodeType type) {
-    ASTNode* node = malloc(sizeof(ASTNode));
-    node->type = type;
-    node->value[0] = '\0';
-    node->left = NULL;
-    node->right = NULL;
-    node->condition = NULL;
-    node->then_branch = NULL;
-    node->else_branch = NULL;
-    node->children = NULL;
-    node->child_count = 0;
-    
-    node->program_id = NULL;
-    node->is_signer = false;
-    node->is_writable = false;
-    node->is_init = false;
-    node->seeds = NULL;
-    node->seed_count = 0;
-    
-    return node;
-}
-
-void ast_free(ASTNode* node) {
-    if (!node) return;
-    
-    ast_free(node->left);
-    ast_free(node->right);
-    ast_free(node->condition);
-    ast_free(node->then_branch);
-    ast_free(node->else_branch);
-    
-    if (node->children) {
-        for (int i = 0; i < node->child_count; i++) {
-            ast_free(node->children[i]);
-        }
-        free(node->children);
-    }
-    
-    if (node->program_id) {
-        free(node->program_id);
-    }
-    if (node->seeds) {
-        for (int i = 0; i < node->seed_count; i++) {
-            free(node->seeds[i]);
-        }
-        free(node->seeds);
-    }
-    
-    free(node);
-}
-
-// ============================================================================
-// PARSER IMPLEMENTATION
-// ============================================================================
-
-Parser* parser_create(Token* tokens, int token_count) {
-    Parser* parser = malloc(sizeof(Parser));
-    parser->tokens = tokens;
-    parser->pos = 0;
-    parser->token_count = token_count;
-    return parser;
-}
-
-static Token* parser_current_token(Parser* parser) {
-    if (parser->pos >= parser->token_count) {
-        return &parser->tokens[parser->token_count - 1]; // EOF token
-    }
-    return &parser->tokens[parser->pos];
-}
-
-static Token* parser_advance(Parser* parser) {
-    Token* token = parser_current_token(parser);
-    if (parser->pos < parser->token_count - 1) {
-        parser->pos++;
-    }
-    return token;
-}
-
-static bool parser_match(Parser* parser, TokenType type) {
-    if (parser_current_token(parser)->type == type) {
-        parser_advance(parser);
-        return true;
-    }
-    return false;
-}
-
-static ASTNode* parser_parse_expression(Parser* parser);
-static ASTNode* parser_parse_statement(Parser* parser);
-
-static ASTNode* parser_parse_program_declaration(Parser* parser);
-static ASTNode* parser_parse_instruction_declaration(Parser* parser);
-static ASTNode* parser_parse_account_constraint(Parser* parser);
-
-static ASTNode* parser_parse_primary(Parser* parser) {
-    Token* token = parser_current_token(parser);
-    ASTNode* node = NULL;
-    
-    if (token->type == TOKEN_NUMBER) {
-        node = ast_create_node(NODE_NUMBER);
-        strcpy(node->value, token->value);
-        parser_advance(parser);
-    } else if (token->type == TOKEN_STRING) {
-        node = ast_create_node(NODE_STRING);
-        strcpy(node->value, token->value);
-        parser_advance(parser);
-    } else if (token->type == TOKEN_IDENTIFIER) {
-        node = ast_create_node(NODE_IDENTIFIER);
-        strcpy(node->value, token->value);
-        parser_advance(parser);
+        list += length;
+        if (*list == ',') list++;
+    }
+    return selected;
+}
+
+// --output names the one file; --output-dir puts each target in a directory
+// of its own, DIR/<target>/<input name>.<c|rs>; otherwise the target's
+// default name in the working directory
+static void target_output_file(TargetJob* job, const char* input, const char* output_file,
+                               const char* output_dir) {
+    if (output_file) {
+        snprintf(job->output_file, sizeof(job->output_file), "%s", output_file);
+    } else if (output_dir) {
+        const char* name = strrchr(input, '/');
+        name = name ? name + 1 : input;
+        if (strcmp(name, "-") == 0) name = "stdin";
         
-        if (parser_current_token(parser)->type == TOKEN_LPAREN) {
-            node->type = NODE_FUNC_CALL;
-            parser_advance(parser); // Skip '('
-            
-            parser_match(parser, TOKEN_RPAREN);
-        }
-    } else if (token->type == TOKEN_LPAREN) {
-        parser_advance(parser);
-        node = parser_parse_expression(parser);
-        parser_match(parser, TOKEN_RPAREN);
+        const char* dot = strrchr(name, '.');
+        int length = dot && dot != name ? (int)(dot - name) : (int)strlen(name);
+        snprintf(job->output_file, sizeof(job->output_file), "%s/%s/%.*s.%s",
+                 output_dir, job->spec->name, length, name, job->spec->extension);
+    } else {
+        snprintf(job->output_file, sizeof(job->output_file), "%s", job->spec->default_file);
     }
-    
-    return node;
 }
 
-static ASTNode* parser_parse_binary(Parser* parser) {
-    ASTNode* left = parser_parse_primary(parser);
-    
-    Token* op = parser_current_token(parser);
-    if (op->type == TOKEN_PLUS || op->type == TOKEN_MINUS || 
-        op->type == TOKEN_MULTIPLY || op->type == TOKEN_DIVIDE ||
-        op->type == TOKEN_EQUAL || op->type == TOKEN_LESS || op->type == TOKEN_GREATER) {
-        
-        parser_advance(parser);
-        ASTNode* right = parser_parse_primary(parser);
-        
-        ASTNode* binary = ast_create_node(NODE_BINARY_OP);
-        strcpy(binary->value, op->value);
-        binary->left = left;
-        binary->right = right;
-        return binary;
-    }
+// Backends only read the tree and write their own buffer
+static void compile_target(void* context, int worker, int task) {
+    TargetRun* run = context;
+    TargetJob* job = &run->jobs[task];
+    (void)worker;
     
-    return left;
-}
-
-static ASTNode* parser_parse_expression(Parser* parser) {
-    return parser_parse_binary(parser);
-}
-
-static ASTNode* parser_parse_statement(Parser* parser) {
-    Token* token = parser_current_token(parser);
-    ASTNode* node = NULL;
-    
-    if (token->type == TOKEN_PROGRAM) {
-        node = parser_parse_program_declaration(parser);
-    } else if (token->type == TOKEN_INSTRUCTION) {
-        node = parser_parse_instruction_declaration(parser);
-    } else if (token->type == TOKEN_LET) {
-        parser_advance(parser);
-        node = ast_create_node(NODE_VAR_DECL);
-        
-        Token* name = parser_current_token(parser);
-        if (name->type == TOKEN_IDENTIFIER) {
-            strcpy(node->value, name->value);
-            parser_advance(parser);
-            
-            if (parser_match(parser, TOKEN_ASSIGN)) {
-                node->right = parser_parse_expression(parser);
-            }
-        }
-    } else if (token->type == TOKEN_PRINT) {
-        parser_advance(parser);
-        node = ast_create_node(NODE_PRINT_STMT);
-        
-        if (parser_match(parser, TOKEN_LPAREN)) {
-            node->left = parser_parse_expression(parser);
-            parser_match(parser, TOKEN_RPAREN);
-        }
-    } else if (token->type == TOKEN_IF) {
-        parser_advance(parser);
-        node = ast_create_node(NODE_IF_STMT);
-        
-        node->condition = parser_parse_expression(parser);
-        
-        if (parser_match(parser, TOKEN_LBRACE)) {
-            node->then_branch = parser_parse_statement(parser);
-            parser_match(parser, TOKEN_RBRACE);
-            
-            if (parser_match(parser, TOKEN_ELSE)) {
-                if (parser_match(parser, TOKEN_LBRACE)) {
-                    node->else_branch = parser_parse_statement(parser);
-                    parser_match(parser, TOKEN_RBRACE);
-                }
-            }
-        }
-    } else if (token->type == TOKEN_RETURN) {
-        parser_advance(parser);
-        node = ast_create_node(NODE_RETURN_STMT);
-        node->left = parser_parse_expression(parser);
+    if (job->solana) {
+        job->written = solana_compiler_compile(job->solana, run->ast);
     } else {
-        node = parser_parse_expression(parser);
-    }
-    
-    while (parser_match(parser, TOKEN_NEWLINE) || parser_match(parser, TOKEN_SEMICOLON)) {
-        // Skip
+        job->written = compiler_compile(job->compiler, run->ast);
     }
-    
-    return node;
 }
 
-ASTNode* parser_parse(Parser* parser) {
-    ASTNode* program = ast_create_node(NODE_PROGRAM);
-    program->children = malloc(sizeof(ASTNode*) * 100);
-    program->child_count = 0;
-    
-    while (parser_current_token(parser)->type != TOKEN_EOF) {
-        ASTNode* stmt = parser_parse_statement(parser);
-        if (stmt) {
-            program->children[program->child_count++] = stmt;
-        }
+// The program declaration of a parsed Solana file
+static const ASTNode* solana_program_of(const ASTNode* file) {
+    for (int i = 0; i < file->as.list.count; i++) {
+        if (file->as.list.items[i]->type == NODE_PROGRAM_DECL) return file->as.list.items[i];
     }
-    
-    return program;
-}
-
-void parser_free(Parser* parser) {
-    free(parser);
-}
-
-// ============================================================================
-// COMPILER IMPLEMENTATION
-// ============================================================================
-
-Compiler* compiler_create(FILE* output, bool to_rust) {
-    Compiler* compiler = malloc(sizeof(Compiler));
-    compiler->output = output;
-    compiler->to_rust = to_rust;
-    compiler->is_solana_program = false;
-    compiler->use_anchor = false;
-    compiler->detected_program_id = NULL;
-    return compiler;
-}
-
-static void compiler_emit_c_headers(Compiler* compiler) {
-    fprintf(compiler->output, "#include <stdio.h>\n");
-    fprintf(compiler->output, "#include <stdlib.h>\n");
-    fprintf(compiler->output, "#include <string.h>\n\n");
+    return NULL;
 }
 
-static void compiler_emit_rust_headers(Compiler* compiler) {
-    if (compiler->is_solana_program) {
-        if (compiler->use_anchor) {
-            fprintf(compiler->output, "use anchor_lang::prelude::*;\n");
-            fprintf(compiler->output, "use anchor_spl::token::{self, Token, TokenAccount, Mint};\n\n");
-        } else {
-            fprintf(compiler->output, "use solana_program::{\n");
-            fprintf(compiler->output, "    account_info::{next_account_info, AccountInfo},\n");
-            fprintf(compiler->output, "    entrypoint,\n");
-            fprintf(compiler->output, "    entrypoint::ProgramResult,\n");
-            fprintf(compiler->output, "    msg,\n");
-            fprintf(compiler->output, "    program_error::ProgramError,\n");
-            fprintf(compiler->output, "    pubkey::Pubkey,\n");
-            fprintf(compiler->output, "};\n\n");
-            fprintf(compiler->output, "entrypoint!(process_instruction);\n\n");
+static void print_target_summary(const TargetJob* job, const ASTNode* program) {
+    printf("Generated: %s\n", job->output_file);
+    
+    if (job->spec->solana) {
+        printf("\nSolana Program Details:\n");
+        if (program && program->as.list.program_id != SYMBOL_NONE) {
+            printf("  Program ID: %s\n", symbol_text(program->as.list.program_id));
         }
+        printf("  Framework: %s\n", job->spec->use_anchor ? "Anchor" : "Native Solana");
+        printf("  Keypair: keypairs/%s-keypair.json\n", 
+               program && program->value ? symbol_text(program->value) : "program");
         
-        if (compiler->detected_program_id) {
-            fprintf(compiler->output, "declare_id!(\"%s\");\n\n", compiler->detected_program_id);
+        printf("\nNext steps:\n");
+        if (job->spec->use_anchor) {
+            printf("  1. Create Anchor project: anchor init my_project\n");
+            printf("  2. Replace programs/my_project/src/lib.rs with generated code\n");
+            printf("  3. Build: anchor build\n");
+            printf("  4. Deploy: anchor deploy\n");
+        } else {
+            printf("  1. Create Cargo project with solana-program dependency\n");
+            printf("  2. Build: cargo build-bpf\n");
+            printf("  3. Deploy: solana program deploy target/deploy/program.so\n");
         }
+    } else if (job->spec == &target_specs[TARGET_RUST]) {
+        printf("To build: rustc %s -o program\n", job->output_file);
     } else {
-        fprintf(compiler->output, "fn main() {\n");
-    }
-}
-
-static void compiler_compile_node(Compiler* compiler, ASTNode* node) {
-    if (!node) return;
-    
-    switch (node->type) {
-        case NODE_PROGRAM:
-            compiler->is_solana_program = detect_solana_program(node);
-            
-            if (compiler->to_rust) {
-                if (compiler->is_solana_program) {
-                    compiler_emit_rust_headers(compiler);
-                } else {
-                    compiler_emit_rust_headers(compiler);
-                }
-            } else {
-                compiler_emit_c_headers(compiler);
-                fprintf(compiler->output, "int main() {\n");
-            }
-            
-            for (int i = 0; i < node->child_count; i++) {
-                compiler_compile_node(compiler, node->children[i]);
-            }
-            
-            if (compiler->to_rust) {
-                if (!compiler->is_solana_program) {
-                    fprintf(compiler->output, "}\n");
-                }
-            } else {
-                fprintf(compiler->output, "    return 0;\n}\n");
-            }
-            break;
-            
-        case NODE_PROGRAM_DECL:
-            compiler->is_solana_program = true;
-            if (node->program_id) {
-                compiler->detected_program_id = malloc(strlen(node->program_id) + 1);
-                strcpy(compiler->detected_program_id, node->program_id);
-            }
-            
-            if (compiler->use_anchor) {
-                fprintf(compiler->output, "#[program]\n");
-                fprintf(compiler->output, "pub mod %s {\n", node->value);
-                fprintf(compiler->output, "    use super::*;\n\n");
-            } else {
-                fprintf(compiler->output, "pub fn process_instruction(\n");
-                fprintf(compiler->output, "    program_id: &Pubkey,\n");
-                fprintf(compiler->output, "    accounts: &[AccountInfo],\n");
-                fprintf(compiler->output, "    instruction_data: &[u8],\n");
-                fprintf(compiler->output, ") -> ProgramResult {\n");
-            }
-            
-            for (int i = 0; i < node->child_count; i++) {
-                compiler_compile_node(compiler, node->children[i]);
-            }
-            
-            if (compiler->use_anchor) {
-                fprintf(compiler->output, "}\n");
-            } else {
-                fprintf(compiler->output, "    Ok(())\n");
-                fprintf(compiler->output, "}\n");
-            }
-            break;
-            
-        case NODE_INSTRUCTION_DECL:
-            if (compiler->use_anchor) {
-                fprintf(compiler->output, "    pub fn %s(ctx: Context<%sContext>) -> Result<()> {\n",
-                        node->value, node->value);
-                
-                if (node->left) {
-                    compiler_compile_node(compiler, node->left);
-                }
-                
-                fprintf(compiler->output, "        Ok(())\n");
-                fprintf(compiler->output, "    }\n\n");
-            } else {
-                fprintf(compiler->output, "    // Instruction: %s\n", node->value);
-                fprintf(compiler->output, "    msg!(\"Executing %s\");\n", node->value);
-                
-                if (node->left) {
-                    compiler_compile_node(compiler, node->left);
-                }
-            }
-            break;
-            
-        case NODE_ACCOUNT_CONSTRAINT:
-            break;
-        case NODE_PROGRAM:
-            if (compiler->to_rust) {
-                compiler_emit_rust_headers(compiler);
-            } else {
-                compiler_emit_c_headers(compiler);
-                fprintf(compiler->output, "int main() {\n");
-            }
-            
-            for (int i = 0; i < node->child_count; i++) {
-                compiler_compile_node(compiler, node->children[i]);
-            }
-            
-            if (compiler->to_rust) {
-                fprintf(compiler->output, "}\n");
-            } else {
-                fprintf(compiler->output, "    return 0;\n}\n");
-            }
-            break;
-            
-        case NODE_VAR_DECL:
-            if (compiler->to_rust) {
-                fprintf(compiler->output, "    let %s = ", node->value);
-            } else {
-                fprintf(compiler->output, "    int %s = ", node->value);
-            }
-            compiler_compile_node(compiler, node->right);
-            fprintf(compiler->output, ";\n");
-            break;
-            
-        case NODE_PRINT_STMT:
-            if (compiler->to_rust) {
-                fprintf(compiler->output, "    println!(\"{}\"");
-            } else {
-                fprintf(compiler->output, "    printf(\"%%d\\n\", ");
-            }
-            if (node->left) {
-                if (compiler->to_rust) fprintf(compiler->output, ", ");
-                compiler_compile_node(compiler, node->left);
-            }
-            fprintf(compiler->output, ");\n");
-            break;
-            
-        case NODE_BINARY_OP:
-            compiler_compile_node(compiler, node->left);
-            fprintf(compiler->output, " %s ", node->value);
-            compiler_compile_node(compiler, node->right);
-            break;
-            
-        case NODE_NUMBER:
-            fprintf(compiler->output, "%s", node->value);
-            break;
-            
-        case NODE_STRING:
-            fprintf(compiler->output, "\"%s\"", node->value);
-            break;
-            
-        case NODE_IDENTIFIER:
-            fprintf(compiler->output, "%s", node->value);
-            break;
-            
-        default:
-            break;
+        printf("To build: gcc %s -o program\n", job->output_file);
     }
 }
 
-void compiler_compile(Compiler* compiler, ASTNode* ast) {
-    compiler_compile_node(compiler, ast);
-}
-
-void compiler_free(Compiler* compiler) {
-    if (compiler->detected_program_id) {
-        free(compiler->detected_program_id);
+static void free_targets(TargetJob* jobs, int count) {
+    for (int i = 0; i < count; i++) {
+        if (jobs[i].output_fp) fclose(jobs[i].output_fp);
+        if (jobs[i].compiler) compiler_free(jobs[i].compiler);
+        if (jobs[i].solana) solana_compiler_free(jobs[i].solana);
     }
-    free(compiler);
 }
 
-// ============================================================================
-// MAIN FUNCTION
-// ============================================================================
-
 int main(int argc, char** argv) {
     if (argc < 2) {
         fprintf(stderr, "So Lang Compiler v2.0 with Solana Support\n");
-        fprintf(stderr, "Usage: %s <input.so> [options]\n", argv[0]);
+        fprintf(stderr, "Usage: %s <input.so | -> [options]\n", argv[0]);
         fprintf(stderr, "Options:\n");
         fprintf(stderr, "  --rust           Compile to Rust\n");
         fprintf(stderr, "  --solana         Force Solana program compilation\n");
         fprintf(stderr, "  --anchor         Use Anchor framework (implies --solana --rust)\n");
-        fprintf(stderr, "  --native-solana  Use native Solana (implies --solana --rust)\n");
+        fprintf(stderr, "  --native-solana  Use native Solana (implies --solana --rust); also --native\n");
+        fprintf(stderr, "  --targets=LIST   Compile once to each of c,rust (core programs) or\n");
+        fprintf(stderr, "                   anchor,native (Solana programs)\n");
+        fprintf(stderr, "  --jobs=N         Parse large files and generate targets on N threads (default: CPU count)\n");
         fprintf(stderr, "  --output FILE    Specify output file\n");
+        fprintf(stderr, "  --output-dir DIR Write each target to DIR/<target>/<input name>\n");
+        fprintf(stderr, "  --max-errors=N   Stop after N errors (default %d)\n", DIAG_DEFAULT_LIMIT);
         return 1;
     }
     
-    bool to_rust = false;
+    int target = TARGET_C;
     bool force_solana = false;
-    bool use_anchor = false;
-    char* output_file = NULL;
+    const char* output_file = NULL;
+    const char* output_dir = NULL;
+    const char* target_list = NULL;
+    int thread_count = parallel_default_jobs();
     
     for (int i = 2; i < argc; i++) {
         if (strcmp(argv[i], "--rust") == 0) {
-            to_rust = true;
+            if (target == TARGET_C) target = TARGET_RUST;
         } else if (strcmp(argv[i], "--solana") == 0) {
             force_solana = true;
-            to_rust = true;
         } else if (strcmp(argv[i], "--anchor") == 0) {
-            force_solana = true;
-            to_rust = true;
-            use_anchor = true;
-        } else if (strcmp(argv[i], "--native-solana") == 0) {
-            force_solana = true;
-            to_rust = true;
-            use_anchor = false;
+            target = TARGET_ANCHOR;
+        } else if (strcmp(argv[i], "--native-solana") == 0 || strcmp(argv[i], "--native") == 0) {
+            target = TARGET_NATIVE;
+        } else if (strncmp(argv[i], "--targets=", 10) == 0) {
+            target_list = argv[i] + 10;
+        } else if (strncmp(argv[i], "--jobs=", 7) == 0) {
+            thread_count = atoi(argv[i] + 7);
+            if (thread_count < 1) thread_count = 1;
         } else if (strcmp(argv[i], "--output") == 0 && i + 1 < argc) {
             output_file = argv[++i];
+        } else if (strcmp(argv[i], "--output-dir") == 0 && i + 1 < argc) {
+            output_dir = argv[++i];
+        } else if (strncmp(argv[i], "--max-errors=", 13) == 0) {
+            diag_set_limit(atoi(argv[i] + 13));
         }
     }
     
-    char* source = read_file(argv[1]);
-    if (!source) return 1;
+    unsigned selected = 1u << target;
+    if (target_list) {
+        selected = parse_targets(target_list);
+        if (!selected) return 1;
+    }
     
-    printf("So Lang Compiler v2.0 with Solana Support\n");
-    printf("Compiling: %s\n", argv[1]);
+    SourceFile* file = read_file(argv[1]);
+    if (!file) return 1;
+    char* source = file->data;
     
-    Lexer* lexer = lexer_create(source);
-    lexer_tokenize(lexer);
+    // The frontend follows the source; a Solana program only compiles to
+    // Solana Rust, so the single-target flags fall back to native for one
+    unsigned solana_targets = (1u << TARGET_ANCHOR) | (1u << TARGET_NATIVE);
+    bool is_solana = force_solana || (selected & solana_targets) || detect_solana_program(source);
     
-    if (has_error) {
-        lexer_free(lexer);
-        free(source);
+    if (is_solana && (selected & ~solana_targets)) {
+        if (target_list) {
+            fprintf(stderr, "%s is a Solana program; it compiles to anchor and native, not c or rust\n", argv[1]);
+            source_file_free(file);
+            return 1;
+        }
+        selected = 1u << TARGET_NATIVE;
+    }
+    
+    TargetJob jobs[TARGET_COUNT];
+    int job_count = 0;
+    for (int i = 0; i < TARGET_COUNT; i++) {
+        if (selected & (1u << i)) {
+            jobs[job_count++] = (TargetJob){&target_specs[i], "", NULL, NULL, NULL, false};
+        }
+    }
+    
+    if (output_file && job_count > 1) {
+        fprintf(stderr, "--output names one file; use --output-dir with several targets\n");
+        source_file_free(file);
         return 1;
     }
     
-    printf("✓ Lexical analysis complete (%d tokens)\n", lexer->token_count);
+    printf("So Lang Compiler v2.0 with Solana Support\n");
+    printf("Compiling: %s\n", argv[1]);
     
-    Parser* parser = parser_create(lexer->tokens, lexer->token_count);
-    ASTNode* ast = parser_parse(parser);
+    Lexer* lexer = lexer_create(source, is_solana ? LEXER_DIALECT_SOLANA : LEXER_DIALECT_CORE);
+    Arena ast_arena;
+    arena_init(&ast_arena);
+    Parser* parser = parser_create(lexer, &ast_arena);
+    parser->jobs = thread_count;
+    ASTNode* ast = is_solana ? solana_parser_parse_file(parser) : parser_parse(parser);
     
-    if (has_error) {
+    if (diag_error_count()) {
+        diag_print(stderr, argv[1], source);
+        diag_reset();
         parser_free(parser);
         lexer_free(lexer);
-        ast_free(ast);
-        free(source);
+        arena_free(&ast_arena);
+        source_file_free(file);
+        symbol_table_free();
         return 1;
     }
     
-    bool is_solana = force_solana || detect_solana_program(ast);
+    printf("✓ Lexical analysis complete (%d tokens)\n", lexer->token_count);
+    ast_fold(&ast_arena, ast);
     
+    const ASTNode* program = is_solana ? solana_program_of(ast) : NULL;
     if (is_solana) {
         printf("✓ Detected Solana program\n");
-        if (detected_program_name) {
-            printf("  Program name: %s\n", detected_program_name);
+        if (program && program->value) {
+            printf("  Program name: %s\n", symbol_text(program->value));
         }
-        to_rust = true; // Solana programs must compile to Rust
     }
     
     printf("✓ Syntax analysis complete\n");
     
-    if (!output_file) {
-        if (is_solana) {
-            if (use_anchor) {
-                output_file = "lib.rs";
-            } else {
-                output_file = "program.rs";
-            }
+    for (int i = 0; i < job_count; i++) {
+        TargetJob* job = &jobs[i];
+        target_output_file(job, argv[1], output_file, output_dir);
+        
+        job->output_fp = fopen(job->output_file, "w");
+        if (!job->output_fp) {
+            fprintf(stderr, "Could not create output file: %s\n", job->output_file);
+            free_targets(jobs, i);
+            return 1;
+        }
+        
+        if (job->spec->solana) {
+            job->solana = solana_compiler_create(job->output_fp, job->spec->use_anchor);
         } else {
-            output_file = to_rust ? "output.rs" : "output.c";
+            job->compiler = compiler_create(job->output_fp, job->spec == &target_specs[TARGET_RUST]);
         }
     }
     
-    FILE* output_fp = fopen(output_file, "w");
-    if (!output_fp) {
-        fprintf(stderr, "Could not create output file: %s\n", output_file);
+    // Each target gets its own buffer and file; the tree is shared
+    TargetRun run = {jobs, ast};
+    parallel_for(job_count, thread_count, compile_target, &run);
+    
+    bool written = true;
+    for (int i = 0; i < job_count; i++) {
+        if (!jobs[i].written) {
+            fprintf(stderr, "Could not write output file: %s\n", jobs[i].output_file);
+            written = false;
+        }
+    }
+    if (!written) {
+        free_targets(jobs, job_count);
         return 1;
     }
     
-    Compiler* compiler = compiler_create(output_fp, to_rust);
-    compiler->is_solana_program = is_solana;
-    compiler->use_anchor = use_anchor;
-    
-    compiler_compile(compiler, ast);
-    
     printf("✓ Code generation complete\n");
-    printf("Generated: %s\n", output_file);
-    
-    if (is_solana) {
-        printf("\nSolana Program Details:\n");
-        if (compiler->detected_program_id) {
-            printf("  Program ID: %s\n", compiler->detected_program_id);
-        }
-        printf("  Framework: %s\n", use_anchor ? "Anchor" : "Native Solana");
-        printf("  Keypair: keypairs/%s-keypair.json\n", 
-               detected_program_name ? detected_program_name : "program");
-        
-        printf("\nNext steps:\n");
-        if (use_anchor) {
-            printf("  1. Create Anchor project: anchor init my_project\n");
-            printf("  2. Replace programs/my_project/src/lib.rs with generated code\n");
-            printf("  3. Build: anchor build\n");
-            printf("  4. Deploy: anchor deploy\n");
-        } else {
-            printf("  1. Create Cargo project with solana-program dependency\n");
-            printf("  2. Build: cargo build-bpf\n");
-            printf("  3. Deploy: solana program deploy target/deploy/program.so\n");
-        }
-    } else if (to_rust) {
-        printf("To build: rustc %s -o program\n", output_file);
-    } else {
-        printf("To build: gcc %s -o program\n", output_file);
+    for (int i = 0; i < job_count; i++) {
+        print_target_summary(&jobs[i], program);
     }
     
     // Cleanup
-    fclose(output_fp);
-    compiler_free(compiler);
+    free_targets(jobs, job_count);
     parser_free(parser);
     lexer_free(lexer);
-    ast_free(ast);
-    free(source);
-    
-    if (detected_program_name) {
-        free(detected_program_name);
-    }
+    arena_free(&ast_arena);
+    source_file_free(file);
+    symbol_table_free();
     
     return 0;
-}
\ No newline at end of file
+}
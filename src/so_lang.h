@@ -11,9 +11,10 @@
 #include <string.h>
 #include <ctype.h>
 #include <stdbool.h>
+#include <stdint.h>
 
 #define MAX_TOKEN_LEN 256
-#define MAX_TOKENS 1000
+#define INITIAL_TOKEN_CAPACITY 256
 #define MAX_VARS 100
 #define MAX_FUNCTIONS 50
 
@@ -33,16 +34,27 @@ typedef enum {
     TOKEN_MINUS,
     TOKEN_MULTIPLY,
     TOKEN_DIVIDE,
+    TOKEN_MODULO,
     TOKEN_EQUAL,
     TOKEN_NOT_EQUAL,
     TOKEN_LESS,
     TOKEN_GREATER,
+    TOKEN_LESS_EQUAL,
+    TOKEN_GREATER_EQUAL,
+    TOKEN_AND,
+    TOKEN_OR,
+    TOKEN_NOT,
     TOKEN_LPAREN,
     TOKEN_RPAREN,
     TOKEN_LBRACE,
     TOKEN_RBRACE,
+    TOKEN_LBRACKET,
+    TOKEN_RBRACKET,
     TOKEN_COMMA,
     TOKEN_SEMICOLON,
+    TOKEN_COLON,
+    TOKEN_DOUBLE_COLON,
+    TOKEN_DOT,
     TOKEN_NEWLINE,
     // Solana-specific tokens
     TOKEN_PROGRAM,
@@ -50,105 +62,354 @@ typedef enum {
     TOKEN_ACCOUNT,
     TOKEN_STATE,
     TOKEN_PUBKEY,
+    TOKEN_LAMPORTS,
     TOKEN_SIGNER,
     TOKEN_WRITABLE,
     TOKEN_INIT,
     TOKEN_SEEDS,
     TOKEN_BUMP,
+    TOKEN_PDA,
     TOKEN_TRANSFER,
+    TOKEN_INVOKE,
     TOKEN_REQUIRE,
+    TOKEN_ERROR,
+    TOKEN_EVENT,
     TOKEN_EMIT,
-    TOKEN_AT_SYMBOL     // @
+    TOKEN_ANCHOR,
+    TOKEN_SOLANA,
+    TOKEN_ENTRYPOINT,
+    TOKEN_PROCESSOR,
+    TOKEN_ACCOUNTS,
+    TOKEN_DATA,
+    TOKEN_INSTRUCTION_DATA,
+    TOKEN_SYSTEM_PROGRAM,
+    TOKEN_TOKEN_PROGRAM,
+    TOKEN_RENT,
+    TOKEN_CLOCK,
+    TOKEN_AT_SYMBOL,    // @
+    TOKEN_HASH,         // #
+    TOKEN_ARROW         // ->
 } TokenType;
 
+// Interned string id; equal ids mean equal text
+typedef uint32_t Symbol;
+#define SYMBOL_NONE 0       // The empty string
+
+// Token text is a slice of the lexer's source buffer, never a copy. Lines
+// and columns are not tracked while lexing; a LineIndex recovers them
 typedef struct {
     TokenType type;
-    char value[MAX_TOKEN_LEN];
-    int line;
-    int column;
+    int start;      // Byte offset of the first character in the source
+    int length;     // Length of the slice in bytes
+    Symbol symbol;  // Interned text of identifiers and strings, else SYMBOL_NONE
 } Token;
 
 typedef enum {
     NODE_PROGRAM,
     NODE_VAR_DECL,
     NODE_FUNC_DECL,
+    NODE_PARAM,
     NODE_IF_STMT,
     NODE_RETURN_STMT,
     NODE_PRINT_STMT,
     NODE_BINARY_OP,
+    NODE_UNARY_OP,
     NODE_IDENTIFIER,
     NODE_NUMBER,
     NODE_STRING,
     NODE_FUNC_CALL,
+    NODE_MEMBER_ACCESS,
     NODE_PROGRAM_DECL,
     NODE_INSTRUCTION_DECL,
     NODE_ACCOUNT_CONSTRAINT,
     NODE_TRANSFER_STMT,
     NODE_REQUIRE_STMT,
-    NODE_EMIT_STMT
+    NODE_EMIT_STMT,
+    // Solana frontend only
+    NODE_ACCOUNT_DECL,
+    NODE_STATE_DECL,
+    NODE_PDA_DERIVATION,
+    NODE_INVOKE_STMT,
+    NODE_ERROR_DECL,
+    NODE_EVENT_DECL,
+    NODE_ACCOUNT_ACCESS,
+    NODE_INSTRUCTION_HANDLER,
+    NODE_ACCOUNT_VALIDATION,
+    NODE_SOLANA_TYPE,
+    NODE_ANCHOR_ATTRIBUTE,
+    NODE_SEEDS_EXPR,
+    NODE_BUMP_EXPR,
+    NODE_ENUM_DECL,
+    NODE_KIND_COUNT
 } NodeType;
 
+// Source text a node was parsed from, as byte offsets
+typedef struct {
+    int start;
+    int length;
+} SourceSpan;
+
+// Side tables of Solana declarations, defined in so_lang_solana.h
+struct ParamTable;
+struct InstructionParam;
+struct TypeLayout;
+
+// 32 bytes on 64-bit hosts; the tag says which member of `as` is live, and
+// identifiers, numbers and strings carry nothing but their symbol. Both
+// frontends build this one type
 typedef struct ASTNode {
-    NodeType type;
-    char value[MAX_TOKEN_LEN];
-    struct ASTNode* left;
-    struct ASTNode* right;
-    struct ASTNode* condition;
-    struct ASTNode* then_branch;
-    struct ASTNode* else_branch;
-    struct ASTNode** children;
-    int child_count;
-    
-    // Solana-specific fields
-    char* program_id;
-    bool is_signer;
-    bool is_writable;
-    bool is_init;
-    char** seeds;
-    int seed_count;
+    uint8_t type;       // NodeType
+    uint8_t op;         // TokenType of unary and binary operators
+    Symbol value;       // Name, literal text, operator, accessed member or parameter
+    SourceSpan span;
+    union {
+        struct {
+            struct ASTNode* left;
+            struct ASTNode* right;
+        } binary;                   // NODE_BINARY_OP; Solana NODE_REQUIRE_STMT
+                                    // as condition and error
+        struct ASTNode* operand;    // Initializer, printed or returned value,
+                                    // unary operand or accessed object
+        struct {
+            struct ASTNode** items;
+            int count;
+            Symbol program_id;      // Solana NODE_PROGRAM_DECL only
+        } list;                     // Programs, blocks, NODE_IF_STMT, call arguments,
+                                    // Solana program bodies and transfer arguments
+        struct {
+            struct ASTNode* body;
+            struct ASTNode* params; // List of NODE_PARAM
+        } function;                 // NODE_FUNC_DECL
+        struct {
+            struct ASTNode* body;
+            struct ParamTable* params;
+        } instruction;              // Solana NODE_INSTRUCTION_DECL
+        struct InstructionParam* account;   // NODE_ACCOUNT_DECL, shaped like an @account parameter
+        struct TypeLayout* layout;  // State, event, enum and error declarations
+        Symbol type_name;           // NODE_PARAM; SYMBOL_NONE when untyped
+    } as;
 } ASTNode;
 
+// Child lists are small vectors: this many slots come with the node, and
+// the capacity doubles each time they fill up
+#define AST_LIST_INLINE 4
+
+// Slots of a NODE_IF_STMT list; the else branch exists when count is 3
+#define IF_CONDITION 0
+#define IF_THEN 1
+#define IF_ELSE 2
+
+// Passes walk the tree with an explicit stack, never the C stack, so any
+// nesting the parser accepts can be visited
+typedef enum {
+    VISIT_CONTINUE,
+    VISIT_SKIP,         // From enter: not into the children. From before: not this child
+    VISIT_STOP          // End the walk
+} VisitAction;
+
+typedef struct {
+    ASTNode* node;
+    int next;           // Child to visit next
+} AstFrame;
+
+typedef struct AstWalk AstWalk;
+
+// Any hook may be NULL. enter and leave bracket every node, and leave runs
+// even when enter skipped the children. before and after bracket each
+// non-NULL child; one that before skipped gets no after
+typedef struct {
+    VisitAction (*enter)(AstWalk* walk, ASTNode* node);
+    VisitAction (*before)(AstWalk* walk, ASTNode* parent, ASTNode* child, int index);
+    VisitAction (*after)(AstWalk* walk, ASTNode* parent, ASTNode* child, int index);
+    VisitAction (*leave)(AstWalk* walk, ASTNode* node);
+} AstVisitor;
+
+#define AST_WALK_INLINE 64
+
+struct AstWalk {
+    const AstVisitor* visitor;
+    void* context;
+    AstFrame* frames;   // frames[depth - 1] is the node being visited
+    int depth;
+    int capacity;
+    AstFrame inline_frames[AST_WALK_INLINE];
+};
+
+// Every problem found in one run is collected before anything is printed
+typedef enum {
+    DIAG_UNEXPECTED_CHARACTER,
+    DIAG_UNTERMINATED_COMMENT,
+    DIAG_UNTERMINATED_STRING,
+    DIAG_UNEXPECTED_TOKEN,
+    DIAG_EXPECTED_TOKEN,
+    DIAG_EXPECTED_EXPRESSION,
+    DIAG_OUT_OF_MEMORY,
+    DIAG_UNKNOWN_TYPE
+} DiagnosticCode;
+
+typedef struct {
+    DiagnosticCode code;
+    int start;              // Byte offset of the offending text
+    int length;
+    const char* message;    // Static text, never freed
+} Diagnostic;
+
+// Errors kept per run; later ones are only counted
+#define DIAG_DEFAULT_LIMIT 100
+
+// Start offset of every line of a source, built on the first lookup
+typedef struct {
+    const char* source;
+    int* line_starts;   // NULL until line_index_locate first runs
+    int line_count;
+} LineIndex;
+
+typedef struct {
+    int line;           // 1-based; 0 if the index could not be built
+    int column;         // 1-based, in bytes
+} SourceLocation;
+
+// Bump allocator; everything in it is released together by arena_free
+typedef struct ArenaBlock ArenaBlock;
+
+typedef struct {
+    ArenaBlock* blocks; // Current block first
+    char* cur;          // Next free byte in the current block
+    char* end;
+    size_t allocations; // arena_alloc calls
+    size_t block_count; // malloc calls
+} Arena;
+
+typedef struct {
+    char* data;         // NUL-terminated contents (read-only when mapped)
+    size_t length;
+    size_t mapped;      // Bytes mapped, 0 when read into the heap
+} SourceFile;
+
+// Keyword sets and attribute syntax of the shared lexer, per frontend
+typedef enum {
+    LEXER_DIALECT_CORE,     // Core programs: core keywords only
+    LEXER_DIALECT_SOLANA    // so_lang_solana.c: every keyword, '@name' attributes
+} LexerDialect;
+
+// Lookahead window of the pull-based lexer; must be a power of two
+#define LEXER_RING_SIZE 16
+#define LEXER_RING_MASK (LEXER_RING_SIZE - 1)
+
 typedef struct {
     char* source;
-    int pos;
-    int line;
-    int column;
-    Token tokens[MAX_TOKENS];
-    int token_count;
+    const char* cur;    // Next byte to scan
+    const char* end;    // One past the last source byte
+    LexerDialect dialect;
+    unsigned keyword_sets;  // KEYWORD_* sets the dialect recognizes
+    Token ring[LEXER_RING_SIZE];    // Scanned tokens not yet consumed
+    int ring_head;      // Index of the next token lexer_next_token returns
+    int token_count;    // Tokens scanned so far
+    bool finished;      // EOF token has been scanned
+    Token* tokens;      // Filled by lexer_tokenize only; grows by doubling
+    int token_capacity;
 } Lexer;
 
 typedef struct {
-    Token* tokens;
-    int pos;
-    int token_count;
+    const char* source;
+    Lexer* lexer;       // Tokens are pulled on demand
+    Arena* arena;       // Owns every node the parser creates
+    bool panicking;     // An error was reported; skip to the next statement
+    int previous_end;   // One past the last consumed token; closes node spans
+    int jobs;           // Threads a top-level parse may use; 1 stays on this one
 } Parser;
 
+// Edges of the pieces a source range is cut into for parallel parsing;
+// piece i is [bounds[i], bounds[i + 1])
+typedef struct {
+    int* bounds;
+    int count;
+    int end;            // Where the scan stopped: the range end or an unmatched '}'
+} DeclarationSplit;
+
+// Runs one piece of work; worker is in [0, jobs) and owns per-thread state
+typedef void (*ParallelTask)(void* context, int worker, int task);
+
+// Pieces smaller than this are not worth a thread of their own
+#define PARALLEL_MIN_CHUNK (64 * 1024)
+#define PARALLEL_MAX_JOBS 64
+
+// Generated code collects here and reaches the output file in a few large
+// writes; the emit_* primitives are in so_lang_emit.h
+typedef struct {
+    char* data;
+    size_t length;
+    size_t capacity;
+    FILE* file;
+    bool failed;        // A write or allocation failed; nothing more is kept
+} Emitter;
+
 typedef struct {
-    FILE* output;
+    Emitter out;
     bool to_rust;
-    bool is_solana_program;
-    bool use_anchor;
-    char* detected_program_id;
 } Compiler;
-Lexer* lexer_create(char* source);
+Lexer* lexer_create(char* source, LexerDialect dialect);
+Lexer* lexer_create_range(char* source, int start, int end, LexerDialect dialect);
+void lexer_seek(Lexer* lexer, int offset);
+Token* lexer_next_token(Lexer* lexer);
+Token* lexer_peek(Lexer* lexer, int n);
 void lexer_tokenize(Lexer* lexer);
 void lexer_free(Lexer* lexer);
 
-Parser* parser_create(Token* tokens, int token_count);
+Parser* parser_create(Lexer* lexer, Arena* arena);
 ASTNode* parser_parse(Parser* parser);
 void parser_free(Parser* parser);
 
-ASTNode* ast_create_node(NodeType type);
-void ast_free(ASTNode* node);
+ASTNode* ast_create_node(Arena* arena, NodeType type);
+ASTNode* ast_create_list_node(Arena* arena, NodeType type);
+void ast_list_append(Arena* arena, ASTNode* list, ASTNode* child);
+
+void arena_init(Arena* arena);
+void* arena_alloc(Arena* arena, size_t size);
+void* arena_list_grow(Arena* arena, void* items, int count, size_t item_size);
+char* arena_strndup(Arena* arena, const char* text, size_t length);
+void arena_adopt(Arena* arena, Arena* other);
+void arena_free(Arena* arena);
 
 Compiler* compiler_create(FILE* output, bool to_rust);
-void compiler_compile(Compiler* compiler, ASTNode* ast);
+bool compiler_compile(Compiler* compiler, ASTNode* ast);
+void compiler_emit_node(Compiler* compiler, ASTNode* node);
 void compiler_free(Compiler* compiler);
 
-void error(const char* message, int line, int column);
-char* read_file(const char* filename);
+void diag_report(DiagnosticCode code, int start, int length, const char* message);
+int diag_error_count(void);
+bool diag_limit_reached(void);
+void diag_set_limit(int limit);
+void diag_print(FILE* out, const char* filename, const char* source);
+void diag_reset(void);
+
+void line_index_init(LineIndex* index, const char* source);
+SourceLocation line_index_locate(LineIndex* index, int offset);
+void line_index_free(LineIndex* index);
+
+SourceFile* read_file(const char* filename);
+void source_file_free(SourceFile* file);
+
+Symbol symbol_intern(const char* text, int length);
+const char* symbol_text(Symbol symbol);
+int symbol_length(Symbol symbol);
+Symbol token_symbol(const char* source, const Token* token);
+void symbol_table_set_shared(bool shared);
+void symbol_table_free(void);
+
+bool split_declarations(const char* source, int start, int end, int min_chunk, DeclarationSplit* split);
+void split_free(DeclarationSplit* split);
+void parallel_for(int task_count, int jobs, ParallelTask task, void* context);
+int parallel_default_jobs(void);
+
+bool ast_walk(ASTNode* root, const AstVisitor* visitor, void* context);
+ASTNode* ast_walk_ancestor(const AstWalk* walk, int generations);
+void ast_fold(Arena* arena, ASTNode* root);
+
+void token_text(const char* source, const Token* token, char* buffer, size_t size);
+bool token_equals(const char* source, const Token* token, const char* text);
 
-bool detect_solana_program(ASTNode* ast);
+bool detect_solana_program(char* source);
 char* generate_program_id(const char* program_name);
 char* get_or_create_program_keypair(const char* program_name);
 void validate_program_id(const char* program_id);
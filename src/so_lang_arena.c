@@ -0,0 +1,117 @@
+/*
+ * so_lang_arena.c - So Lang Bump Allocator
+ * AST nodes and everything hanging off them come from one arena per
+ * compilation and are released together
+ */
+
+#include "so_lang.h"
+
+#define ARENA_BLOCK_SIZE (64 * 1024)
+#define ARENA_ALIGN 16
+
+struct ArenaBlock {
+    struct ArenaBlock* next;
+    size_t capacity;
+    // Payload follows, aligned to ARENA_ALIGN
+};
+
+#define ARENA_HEADER ((sizeof(ArenaBlock) + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1))
+
+void arena_init(Arena* arena) {
+    arena->blocks = NULL;
+    arena->cur = NULL;
+    arena->end = NULL;
+    arena->allocations = 0;
+    arena->block_count = 0;
+}
+
+static ArenaBlock* arena_new_block(Arena* arena, size_t capacity) {
+    ArenaBlock* block = malloc(ARENA_HEADER + capacity);
+    if (!block) {
+        fprintf(stderr, "Out of memory for the AST arena\n");
+        exit(1);
+    }
+    block->capacity = capacity;
+    arena->block_count++;
+    return block;
+}
+
+// Zeroed, ARENA_ALIGN-aligned and contiguous with the previous allocation
+// whenever it fits in the current block
+void* arena_alloc(Arena* arena, size_t size) {
+    size = (size + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+    arena->allocations++;
+
+    if ((size_t)(arena->end - arena->cur) < size) {
+        // Oversized requests get a block of their own behind the current
+        // one, so the free space left in the current block is not lost
+        if (size > ARENA_BLOCK_SIZE / 4 && arena->blocks) {
+            ArenaBlock* block = arena_new_block(arena, size);
+            block->next = arena->blocks->next;
+            arena->blocks->next = block;
+            char* memory = (char*)block + ARENA_HEADER;
+            memset(memory, 0, size);
+            return memory;
+        }
+
+        size_t capacity = size > ARENA_BLOCK_SIZE ? size : ARENA_BLOCK_SIZE;
+        ArenaBlock* block = arena_new_block(arena, capacity);
+        block->next = arena->blocks;
+        arena->blocks = block;
+        arena->cur = (char*)block + ARENA_HEADER;
+        arena->end = arena->cur + capacity;
+    }
+
+    char* memory = arena->cur;
+    arena->cur += size;
+    memset(memory, 0, size);
+    return memory;
+}
+
+// Room for one more item in a small vector of `count` items. Its capacity
+// is AST_LIST_INLINE, then the next power of two, so it is full exactly when
+// count is one of those; the old slots stay behind in the arena
+void* arena_list_grow(Arena* arena, void* items, int count, size_t item_size) {
+    if (count < AST_LIST_INLINE || (count & (count - 1)) != 0) return items;
+    void* grown = arena_alloc(arena, item_size * count * 2);
+    memcpy(grown, items, item_size * count);
+    return grown;
+}
+
+// Takes over every block of `other`, which is left empty. They go behind
+// the current block, so allocation carries on where it was
+void arena_adopt(Arena* arena, Arena* other) {
+    if (!other->blocks) return;
+
+    ArenaBlock* last = other->blocks;
+    while (last->next) last = last->next;
+
+    if (arena->blocks) {
+        last->next = arena->blocks->next;
+        arena->blocks->next = other->blocks;
+    } else {
+        arena->blocks = other->blocks;
+        arena->cur = other->cur;
+        arena->end = other->end;
+    }
+
+    arena->allocations += other->allocations;
+    arena->block_count += other->block_count;
+    arena_init(other);
+}
+
+char* arena_strndup(Arena* arena, const char* text, size_t length) {
+    char* copy = arena_alloc(arena, length + 1);
+    memcpy(copy, text, length);
+    copy[length] = '\0';
+    return copy;
+}
+
+void arena_free(Arena* arena) {
+    while (arena->blocks) {
+        ArenaBlock* next = arena->blocks->next;
+        free(arena->blocks);
+        arena->blocks = next;
+    }
+    arena_init(arena);
+}
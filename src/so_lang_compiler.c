@@ -0,0 +1,373 @@
+/*
+ * so_lang_compiler.c - So Lang Core Code Generator
+ * Emits a core program as C or Rust through the backend tables of
+ * so_lang_emit.h; the Solana compiler embeds it for statements
+ */
+
+#include "so_lang.h"
+#include "so_lang_operators.h"
+#include "so_lang_emit.h"
+
+// ============================================================================
+// COMPILER
+// ============================================================================
+
+Compiler* compiler_create(FILE* output, bool to_rust) {
+    Compiler* compiler = malloc(sizeof(Compiler));
+    emitter_init(&compiler->out, output);
+    compiler->to_rust = to_rust;
+    return compiler;
+}
+
+static const char c_headers[] =
+    "#include <stdio.h>\n"
+    "#include <stdlib.h>\n"
+    "#include <string.h>\n\n";
+
+// C and Rust spellings of the scalar types a parameter can be declared
+// with; anything else is an int, like every other value in the core language
+static const char* compiler_param_type(const Compiler* compiler, Symbol type_name) {
+    static const struct {
+        const char* name;
+        const char* c_type;
+        const char* rust_type;
+    } scalar_types[] = {
+        {"u8", "unsigned char", "u8"}, {"u16", "unsigned short", "u16"},
+        {"u32", "unsigned int", "u32"}, {"u64", "unsigned long long", "u64"},
+        {"i8", "signed char", "i8"}, {"i16", "short", "i16"},
+        {"i32", "int", "i32"}, {"i64", "long long", "i64"},
+        {"f32", "float", "f32"}, {"f64", "double", "f64"},
+        {"bool", "int", "bool"}, {"int", "int", "i32"},
+    };
+
+    const char* name = symbol_text(type_name);
+    for (size_t i = 0; i < sizeof(scalar_types) / sizeof(scalar_types[0]); i++) {
+        if (strcmp(name, scalar_types[i].name) == 0) {
+            return compiler->to_rust ? scalar_types[i].rust_type : scalar_types[i].c_type;
+        }
+    }
+    return compiler->to_rust ? "i32" : "int";
+}
+
+static void compiler_compile_params(Compiler* compiler, const ASTNode* params) {
+    for (int i = 0; params && i < params->as.list.count; i++) {
+        const ASTNode* param = params->as.list.items[i];
+        if (i > 0) emit_str(&compiler->out, ", ");
+        
+        if (compiler->to_rust) {
+            emit_sym(&compiler->out, param->value);
+            emit_str(&compiler->out, ": ");
+            emit_str(&compiler->out, compiler_param_type(compiler, param->as.type_name));
+        } else {
+            emit_str(&compiler->out, compiler_param_type(compiler, param->as.type_name));
+            emit_char(&compiler->out, ' ');
+            emit_sym(&compiler->out, param->value);
+        }
+    }
+}
+
+// The emitter is a set of walk hooks, with the Compiler as the walk's
+// context: enter writes what comes before a node's children, before and
+// after what goes around each child, and leave what closes the node
+
+// Operands go in parentheses only where precedence alone would regroup
+// them; a tree parsed from flat text never needs any
+static bool compiler_needs_parens(const ASTNode* parent, const ASTNode* child, int index) {
+    switch (parent->type) {
+        case NODE_BINARY_OP:     return ast_needs_parens(child, parent, index == 1);
+        case NODE_UNARY_OP:      return ast_needs_parens(child, parent, true);
+        case NODE_MEMBER_ACCESS: return ast_needs_parens(child, parent, false);
+        default:                 return false;
+    }
+}
+
+static VisitAction compiler_enter(AstWalk* walk, ASTNode* node) {
+    Compiler* compiler = walk->context;
+
+    switch (node->type) {
+        case NODE_PROGRAM:
+        case NODE_BINARY_OP:
+        case NODE_MEMBER_ACCESS:
+            break;
+            
+        case NODE_VAR_DECL:
+            if (compiler->to_rust) {
+                emit_str(&compiler->out, "    let ");
+                emit_sym(&compiler->out, node->value);
+                emit_str(&compiler->out, " = ");
+            } else {
+                emit_str(&compiler->out, "    int ");
+                emit_sym(&compiler->out, node->value);
+                emit_str(&compiler->out, " = ");
+            }
+            break;
+            
+        case NODE_PRINT_STMT:
+            if (compiler->to_rust) {
+                emit_str(&compiler->out, "    println!(\"{}\"");
+            } else {
+                emit_str(&compiler->out, "    printf(\"%d\\n\", ");
+            }
+            break;
+            
+        case NODE_IF_STMT:
+            if (compiler->to_rust) {
+                emit_str(&compiler->out, "    if ");
+            } else {
+                emit_str(&compiler->out, "    if (");
+            }
+            break;
+            
+        case NODE_RETURN_STMT:
+            emit_str(&compiler->out, "    return ");
+            break;
+            
+        case NODE_UNARY_OP:
+            emit_sym(&compiler->out, node->value);
+            break;
+            
+        case NODE_NUMBER:
+        case NODE_IDENTIFIER:
+            emit_sym(&compiler->out, node->value);
+            break;
+            
+        case NODE_STRING:
+            emit_char(&compiler->out, '"');
+            emit_sym(&compiler->out, node->value);
+            emit_char(&compiler->out, '"');
+            break;
+            
+        case NODE_FUNC_CALL:
+            emit_sym(&compiler->out, node->value);
+            emit_char(&compiler->out, '(');
+            break;
+            
+        default:
+            return VISIT_SKIP;
+    }
+    return VISIT_CONTINUE;
+}
+
+static VisitAction compiler_before(AstWalk* walk, ASTNode* parent, ASTNode* child, int index) {
+    Compiler* compiler = walk->context;
+
+    switch (parent->type) {
+        case NODE_PROGRAM: {
+            // Statements of an if's branches sit one step further in
+            ASTNode* owner = ast_walk_ancestor(walk, 1);
+            if (owner && owner->type == NODE_IF_STMT) {
+                emit_indent(&compiler->out, 1);
+            }
+            // Functions are emitted ahead of main, never in place
+            if (child->type == NODE_FUNC_DECL) return VISIT_SKIP;
+            break;
+        }
+            
+        case NODE_PRINT_STMT:
+            if (compiler->to_rust) emit_str(&compiler->out, ", ");
+            break;
+            
+        case NODE_IF_STMT:
+            if (index == IF_THEN) {
+                if (!compiler->to_rust) {
+                    emit_char(&compiler->out, ')');
+                }
+                emit_str(&compiler->out, " {\n");
+            } else if (index == IF_ELSE) {
+                emit_str(&compiler->out, "    } else {\n");
+                if (child->type == NODE_IF_STMT) {
+                    emit_indent(&compiler->out, 1);
+                }
+            }
+            break;
+            
+        case NODE_BINARY_OP:
+            if (index == 1) {
+                emit_char(&compiler->out, ' ');
+                emit_sym(&compiler->out, parent->value);
+                emit_char(&compiler->out, ' ');
+            }
+            break;
+            
+        case NODE_FUNC_CALL:
+            if (index > 0) emit_str(&compiler->out, ", ");
+            break;
+            
+        default:
+            break;
+    }
+
+    if (compiler_needs_parens(parent, child, index)) {
+        emit_char(&compiler->out, '(');
+    }
+    return VISIT_CONTINUE;
+}
+
+static VisitAction compiler_after(AstWalk* walk, ASTNode* parent, ASTNode* child, int index) {
+    Compiler* compiler = walk->context;
+
+    if (compiler_needs_parens(parent, child, index)) {
+        emit_char(&compiler->out, ')');
+    }
+    return VISIT_CONTINUE;
+}
+
+static VisitAction compiler_leave(AstWalk* walk, ASTNode* node) {
+    Compiler* compiler = walk->context;
+
+    switch (node->type) {
+        case NODE_VAR_DECL:
+        case NODE_RETURN_STMT:
+            if (!node->as.operand) {
+                emit_char(&compiler->out, '0');
+            }
+            emit_str(&compiler->out, ";\n");
+            break;
+            
+        case NODE_PRINT_STMT:
+            emit_str(&compiler->out, ");\n");
+            break;
+            
+        case NODE_IF_STMT:
+            emit_str(&compiler->out, "    }\n");
+            break;
+            
+        case NODE_MEMBER_ACCESS:
+            emit_char(&compiler->out, '.');
+            emit_sym(&compiler->out, node->value);
+            break;
+            
+        case NODE_FUNC_CALL:
+            emit_char(&compiler->out, ')');
+            break;
+            
+        default:
+            break;
+    }
+    return VISIT_CONTINUE;
+}
+
+static const AstVisitor compiler_emitter = {
+    compiler_enter, compiler_before, compiler_after, compiler_leave
+};
+
+// Programs and functions are shaped differently in C and Rust, so each
+// target has emitters of its own for them. Statements and expressions
+// differ token by token and go through the walk hooks above, on an
+// explicit stack however deep they nest
+static void emit_walk(void* context, ASTNode* node) {
+    ast_walk(node, &compiler_emitter, context);
+}
+
+// The body is walked on its own: the signature already lists the parameters
+static void emit_c_function(void* context, ASTNode* function) {
+    Compiler* compiler = context;
+    emit_str(&compiler->out, "int ");
+    emit_sym(&compiler->out, function->value);
+    emit_char(&compiler->out, '(');
+    compiler_compile_params(compiler, function->as.function.params);
+    emit_str(&compiler->out, ") {\n");
+
+    ast_walk(function->as.function.body, &compiler_emitter, compiler);
+
+    // Default return if no explicit return
+    emit_str(&compiler->out, "    return 0;\n}\n\n");
+}
+
+static void emit_rust_function(void* context, ASTNode* function) {
+    Compiler* compiler = context;
+    emit_str(&compiler->out, "fn ");
+    emit_sym(&compiler->out, function->value);
+    emit_char(&compiler->out, '(');
+    compiler_compile_params(compiler, function->as.function.params);
+    emit_str(&compiler->out, ") -> i32 {\n");
+
+    ast_walk(function->as.function.body, &compiler_emitter, compiler);
+
+    emit_str(&compiler->out, "    0\n}\n\n");
+}
+
+// Functions first, then main() with the remaining top-level statements
+static void emit_c_program(void* context, ASTNode* program) {
+    Compiler* compiler = context;
+    emit_literal(&compiler->out, c_headers);
+
+    for (int i = 0; i < program->as.list.count; i++) {
+        if (program->as.list.items[i]->type == NODE_FUNC_DECL) {
+            emit_c_function(compiler, program->as.list.items[i]);
+        }
+    }
+
+    emit_str(&compiler->out, "int main() {\n");
+    ast_walk(program, &compiler_emitter, compiler);
+    emit_str(&compiler->out, "    return 0;\n}\n");
+}
+
+static void emit_rust_program(void* context, ASTNode* program) {
+    Compiler* compiler = context;
+
+    for (int i = 0; i < program->as.list.count; i++) {
+        if (program->as.list.items[i]->type == NODE_FUNC_DECL) {
+            emit_rust_function(compiler, program->as.list.items[i]);
+        }
+    }
+
+    emit_str(&compiler->out, "fn main() {\n");
+    ast_walk(program, &compiler_emitter, compiler);
+    emit_str(&compiler->out, "}\n");
+}
+
+static const Backend c_backend = {
+    "c",
+    {
+        [NODE_PROGRAM]       = emit_c_program,
+        [NODE_VAR_DECL]      = emit_walk,
+        [NODE_FUNC_DECL]     = emit_c_function,
+        [NODE_IF_STMT]       = emit_walk,
+        [NODE_RETURN_STMT]   = emit_walk,
+        [NODE_PRINT_STMT]    = emit_walk,
+        [NODE_BINARY_OP]     = emit_walk,
+        [NODE_UNARY_OP]      = emit_walk,
+        [NODE_IDENTIFIER]    = emit_walk,
+        [NODE_NUMBER]        = emit_walk,
+        [NODE_STRING]        = emit_walk,
+        [NODE_FUNC_CALL]     = emit_walk,
+        [NODE_MEMBER_ACCESS] = emit_walk,
+    },
+};
+
+static const Backend rust_backend = {
+    "rust",
+    {
+        [NODE_PROGRAM]       = emit_rust_program,
+        [NODE_VAR_DECL]      = emit_walk,
+        [NODE_FUNC_DECL]     = emit_rust_function,
+        [NODE_IF_STMT]       = emit_walk,
+        [NODE_RETURN_STMT]   = emit_walk,
+        [NODE_PRINT_STMT]    = emit_walk,
+        [NODE_BINARY_OP]     = emit_walk,
+        [NODE_UNARY_OP]      = emit_walk,
+        [NODE_IDENTIFIER]    = emit_walk,
+        [NODE_NUMBER]        = emit_walk,
+        [NODE_STRING]        = emit_walk,
+        [NODE_FUNC_CALL]     = emit_walk,
+        [NODE_MEMBER_ACCESS] = emit_walk,
+    },
+};
+
+// One node and everything under it, left in the buffer; backends that
+// embed a Compiler emit core statements through this
+void compiler_emit_node(Compiler* compiler, ASTNode* node) {
+    if (node) backend_emit(compiler->to_rust ? &rust_backend : &c_backend, compiler, node);
+}
+
+// Everything generated is written out before this returns
+bool compiler_compile(Compiler* compiler, ASTNode* ast) {
+    compiler_emit_node(compiler, ast);
+    return emitter_flush(&compiler->out);
+}
+
+void compiler_free(Compiler* compiler) {
+    emitter_free(&compiler->out);
+    free(compiler);
+}
@@ -0,0 +1,118 @@
+/*
+ * so_lang_diag.c - So Lang Diagnostics Buffer
+ * Lexer and parser errors are recorded here and printed together, so one
+ * run reports every problem in the file
+ */
+
+#include <pthread.h>
+
+#include "so_lang.h"
+
+// Stable codes for tools that match on them; indexed by DiagnosticCode
+static const char* const diag_code_names[] = {
+    [DIAG_UNEXPECTED_CHARACTER] = "E001",
+    [DIAG_UNTERMINATED_COMMENT] = "E002",
+    [DIAG_UNTERMINATED_STRING]  = "E003",
+    [DIAG_UNEXPECTED_TOKEN]     = "E004",
+    [DIAG_EXPECTED_TOKEN]       = "E005",
+    [DIAG_EXPECTED_EXPRESSION]  = "E006",
+    [DIAG_OUT_OF_MEMORY]        = "E007",
+    [DIAG_UNKNOWN_TYPE]         = "E008",
+};
+
+static struct {
+    Diagnostic* items;
+    int count;
+    int capacity;
+    int limit;      // 0 until first use, then DIAG_DEFAULT_LIMIT unless set
+    int dropped;    // Reported after the limit was reached
+} diagnostics;
+
+// Parser threads report concurrently; errors are rare enough to lock always
+static pthread_mutex_t diagnostics_lock = PTHREAD_MUTEX_INITIALIZER;
+
+// Counters and the limit are only written under the lock, but stored
+// atomically for the lock-free readers below
+static void diag_drop(void) {
+    __atomic_store_n(&diagnostics.dropped, diagnostics.dropped + 1, __ATOMIC_RELEASE);
+}
+
+static void diag_append(DiagnosticCode code, int start, int length, const char* message) {
+    if (!diagnostics.limit) __atomic_store_n(&diagnostics.limit, DIAG_DEFAULT_LIMIT, __ATOMIC_RELEASE);
+
+    if (diagnostics.count >= diagnostics.limit) {
+        diag_drop();
+        return;
+    }
+
+    if (diagnostics.count == diagnostics.capacity) {
+        int capacity = diagnostics.capacity ? diagnostics.capacity * 2 : 16;
+        if (capacity > diagnostics.limit) capacity = diagnostics.limit;
+        Diagnostic* items = realloc(diagnostics.items, sizeof(Diagnostic) * capacity);
+        if (!items) {
+            diag_drop();
+            return;
+        }
+        diagnostics.items = items;
+        diagnostics.capacity = capacity;
+    }
+
+    diagnostics.items[diagnostics.count] = (Diagnostic){code, start, length, message};
+    __atomic_store_n(&diagnostics.count, diagnostics.count + 1, __ATOMIC_RELEASE);
+}
+
+void diag_report(DiagnosticCode code, int start, int length, const char* message) {
+    pthread_mutex_lock(&diagnostics_lock);
+    diag_append(code, start, length, message);
+    pthread_mutex_unlock(&diagnostics_lock);
+}
+
+// Both may be polled by parser threads while others report
+int diag_error_count(void) {
+    return __atomic_load_n(&diagnostics.count, __ATOMIC_ACQUIRE) +
+           __atomic_load_n(&diagnostics.dropped, __ATOMIC_ACQUIRE);
+}
+
+// Callers stop parsing once this holds; nothing more would be shown
+bool diag_limit_reached(void) {
+    int limit = __atomic_load_n(&diagnostics.limit, __ATOMIC_ACQUIRE);
+    return limit && __atomic_load_n(&diagnostics.count, __ATOMIC_ACQUIRE) >= limit;
+}
+
+void diag_set_limit(int limit) {
+    pthread_mutex_lock(&diagnostics_lock);
+    __atomic_store_n(&diagnostics.limit, limit > 0 ? limit : DIAG_DEFAULT_LIMIT, __ATOMIC_RELEASE);
+    pthread_mutex_unlock(&diagnostics_lock);
+}
+
+// One "file:line:column: error E004: message" line per diagnostic, in the
+// order they were found, then a summary. Lines are only indexed when there
+// is something to print
+void diag_print(FILE* out, const char* filename, const char* source) {
+    LineIndex lines;
+    line_index_init(&lines, source);
+
+    for (int i = 0; i < diagnostics.count; i++) {
+        const Diagnostic* diag = &diagnostics.items[i];
+        SourceLocation location = line_index_locate(&lines, diag->start);
+
+        fprintf(out, "%s:%d:%d: error %s: %s\n", filename, location.line, location.column,
+                diag_code_names[diag->code], diag->message);
+    }
+    line_index_free(&lines);
+
+    int total = diag_error_count();
+    if (diagnostics.dropped) {
+        fprintf(out, "%d errors; only the first %d are shown\n", total, diagnostics.count);
+    } else if (total) {
+        fprintf(out, "%d error%s\n", total, total == 1 ? "" : "s");
+    }
+}
+
+// Forgets every diagnostic but keeps the limit
+void diag_reset(void) {
+    int limit = diagnostics.limit;
+    free(diagnostics.items);
+    memset(&diagnostics, 0, sizeof(diagnostics));
+    diagnostics.limit = limit;
+}
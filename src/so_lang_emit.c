@@ -0,0 +1,171 @@
+/*
+ * so_lang_emit.c - So Lang Output Buffer
+ * Growth, number formatting, templates and the writes behind so_lang_emit.h
+ */
+
+#ifndef _DEFAULT_SOURCE
+#define _DEFAULT_SOURCE     // fileno
+#endif
+
+#include <errno.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include "so_lang_emit.h"
+
+void emitter_init(Emitter* emitter, FILE* file) {
+    emitter->data = malloc(EMIT_INITIAL_CAPACITY);
+    emitter->length = 0;
+    emitter->capacity = emitter->data ? EMIT_INITIAL_CAPACITY : 0;
+    emitter->file = file;
+    emitter->failed = !emitter->data;
+}
+
+// Straight to the descriptor when there is one, so the bytes are not
+// copied again into stdio's buffer; memory streams go through fwrite
+static bool emitter_write(Emitter* emitter, const char* data, size_t length) {
+    int fd = fileno(emitter->file);
+    if (fd < 0) return fwrite(data, 1, length, emitter->file) == length;
+
+    // Anything already in the stream goes first
+    if (fflush(emitter->file) != 0) return false;
+
+    while (length > 0) {
+        ssize_t written = write(fd, data, length);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        data += written;
+        length -= (size_t)written;
+    }
+    return true;
+}
+
+// Writes out everything buffered; false once any write has failed
+bool emitter_flush(Emitter* emitter) {
+    if (emitter->length > 0 && !emitter->failed) {
+        if (!emitter_write(emitter, emitter->data, emitter->length)) emitter->failed = true;
+    }
+    emitter->length = 0;
+    return !emitter->failed;
+}
+
+// Room for `length` more bytes: the buffer doubles up to EMIT_MAX_CAPACITY,
+// then is written out to make space. False if the bytes should be dropped
+bool emitter_reserve(Emitter* emitter, size_t length) {
+    if (emitter->failed) return false;
+
+    size_t needed = emitter->length + length;
+    if (needed <= emitter->capacity) return true;
+
+    if (needed > EMIT_MAX_CAPACITY && emitter->length > 0) {
+        if (!emitter_flush(emitter)) return false;
+        needed = length;
+        if (needed <= emitter->capacity) return true;
+    }
+
+    size_t capacity = emitter->capacity ? emitter->capacity : EMIT_INITIAL_CAPACITY;
+    while (capacity < needed) capacity *= 2;
+
+    char* data = realloc(emitter->data, capacity);
+    if (!data) {
+        emitter->failed = true;
+        return false;
+    }
+    emitter->data = data;
+    emitter->capacity = capacity;
+    return true;
+}
+
+void emit_int(Emitter* emitter, long long value) {
+    char digits[24];
+    char* p = digits + sizeof(digits);
+    unsigned long long magnitude = value < 0 ? 0ULL - (unsigned long long)value : (unsigned long long)value;
+
+    do {
+        *--p = (char)('0' + magnitude % 10);
+        magnitude /= 10;
+    } while (magnitude);
+    if (value < 0) *--p = '-';
+
+    emit_bytes(emitter, p, (size_t)(digits + sizeof(digits) - p));
+}
+
+void emit_indent(Emitter* emitter, int levels) {
+    while (levels-- > 0) {
+        emit_bytes(emitter, EMIT_INDENT, sizeof(EMIT_INDENT) - 1);
+    }
+}
+
+// Backends for several targets may reach a template for the first time together
+static pthread_mutex_t template_lock = PTHREAD_MUTEX_INITIALIZER;
+
+// Splits the text at its {{name}} slots. Templates are written by hand, so
+// a malformed one is a bug: an unclosed slot or too many pieces aborts
+static void template_compile(Template* template) {
+    pthread_mutex_lock(&template_lock);
+    if (template->compiled) {
+        pthread_mutex_unlock(&template_lock);
+        return;
+    }
+
+    const char* text = template->text;
+    const char* names[TEMPLATE_MAX_PIECES];
+    int name_lengths[TEMPLATE_MAX_PIECES];
+    int name_count = 0;
+    int count = 0;
+    const char* p = text;
+
+    for (;;) {
+        const char* open = strstr(p, "{{");
+        const char* literal_end = open ? open : p + strlen(p);
+
+        if (literal_end > p) {
+            if (count == TEMPLATE_MAX_PIECES) abort();
+            template->pieces[count++] = (TemplatePiece){
+                (uint16_t)(p - text), (uint16_t)(literal_end - p), -1};
+        }
+        if (!open) break;
+
+        const char* name = open + 2;
+        const char* close = strstr(name, "}}");
+        if (!close || count == TEMPLATE_MAX_PIECES) abort();
+
+        int length = (int)(close - name);
+        int slot = 0;
+        while (slot < name_count && (name_lengths[slot] != length || memcmp(names[slot], name, length) != 0)) {
+            slot++;
+        }
+        if (slot == name_count) {
+            names[name_count] = name;
+            name_lengths[name_count++] = length;
+        }
+
+        template->pieces[count++] = (TemplatePiece){0, 0, (int8_t)slot};
+        p = close + 2;
+    }
+
+    template->piece_count = count;
+    __atomic_store_n(&template->compiled, true, __ATOMIC_RELEASE);
+    pthread_mutex_unlock(&template_lock);
+}
+
+void emit_template(Emitter* emitter, Template* template, const Symbol* values) {
+    if (!__atomic_load_n(&template->compiled, __ATOMIC_ACQUIRE)) template_compile(template);
+
+    for (int i = 0; i < template->piece_count; i++) {
+        if (template->pieces[i].slot < 0) {
+            emit_bytes(emitter, template->text + template->pieces[i].start, template->pieces[i].length);
+        } else {
+            emit_sym(emitter, values[template->pieces[i].slot]);
+        }
+    }
+}
+
+void emitter_free(Emitter* emitter) {
+    free(emitter->data);
+    emitter->data = NULL;
+    emitter->length = 0;
+    emitter->capacity = 0;
+}
@@ -0,0 +1,87 @@
+/*
+ * so_lang_emit.h - So Lang Output Buffer
+ * Code generators append fragments to an Emitter instead of formatting each
+ * one through stdio; the buffer is written out in large pieces
+ */
+
+#ifndef SO_LANG_EMIT_H
+#define SO_LANG_EMIT_H
+
+#include "so_lang.h"
+
+// Buffers grow to this before they are written out; most programs fit, so
+// their output takes one write
+#define EMIT_INITIAL_CAPACITY (64 * 1024)
+#define EMIT_MAX_CAPACITY (4 * 1024 * 1024)
+
+#define EMIT_INDENT "    "
+
+#define TEMPLATE_MAX_PIECES 16
+
+// A snippet with {{name}} slots, filled from an array of Symbols: the first
+// distinct name takes values[0], the next values[1], and so on. The text is
+// split into literal runs and slots once, on first use
+typedef struct {
+    uint16_t start;     // Literal run in the text
+    uint16_t length;
+    int8_t slot;        // Or the value filling this piece; -1 for a literal
+} TemplatePiece;
+
+typedef struct {
+    const char* text;
+    bool compiled;
+    int piece_count;
+    TemplatePiece pieces[TEMPLATE_MAX_PIECES];
+} Template;
+
+#define TEMPLATE(literal) {(literal), false, 0, {{0, 0, 0}}}
+
+// A code generator: one emit function per node tag, each handed the
+// backend's own state as context. Dispatch is a single indexed load, so a
+// backend pays nothing for the kinds and the other backends it does not handle
+typedef void (*NodeEmitter)(void* context, ASTNode* node);
+
+typedef struct {
+    const char* name;
+    NodeEmitter emit[NODE_KIND_COUNT];  // NULL for kinds that emit nothing
+} Backend;
+
+static inline void backend_emit(const Backend* backend, void* context, ASTNode* node) {
+    NodeEmitter emit = backend->emit[node->type];
+    if (emit) emit(context, node);
+}
+
+void emitter_init(Emitter* emitter, FILE* file);
+bool emitter_flush(Emitter* emitter);
+void emitter_free(Emitter* emitter);
+
+bool emitter_reserve(Emitter* emitter, size_t length);
+void emit_int(Emitter* emitter, long long value);
+void emit_indent(Emitter* emitter, int levels);
+void emit_template(Emitter* emitter, Template* template, const Symbol* values);
+
+static inline void emit_bytes(Emitter* emitter, const char* text, size_t length) {
+    if (length > emitter->capacity - emitter->length && !emitter_reserve(emitter, length)) return;
+    memcpy(emitter->data + emitter->length, text, length);
+    emitter->length += length;
+}
+
+// A string literal or a static char array, with its length known at compile
+// time: constant boilerplate goes out as one copy
+#define emit_literal(emitter, text) emit_bytes((emitter), (text), sizeof(text) - 1)
+
+// The length of a literal is folded at compile time once this is inlined
+static inline void emit_str(Emitter* emitter, const char* text) {
+    emit_bytes(emitter, text, strlen(text));
+}
+
+static inline void emit_char(Emitter* emitter, char c) {
+    if (emitter->length == emitter->capacity && !emitter_reserve(emitter, 1)) return;
+    emitter->data[emitter->length++] = c;
+}
+
+static inline void emit_sym(Emitter* emitter, Symbol symbol) {
+    emit_bytes(emitter, symbol_text(symbol), (size_t)symbol_length(symbol));
+}
+
+#endif // SO_LANG_EMIT_H
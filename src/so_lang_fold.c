@@ -0,0 +1,439 @@
+/*
+ * so_lang_fold.c - So Lang Constant Folding
+ * Rewrites the tree before code generation: arithmetic on constants is
+ * computed, `let` constants are substituted into their uses, and branches
+ * a constant condition rules out are dropped
+ */
+
+#include "so_lang.h"
+
+// Values are those of the core targets' C int and Rust i32. A result out
+// of that range is not folded, so the target reports or wraps it as before
+#define FOLD_MIN (-2147483647 - 1)
+#define FOLD_MAX 2147483647
+
+// Conditions are judged recursively, and give up past this depth
+#define FOLD_TRUTH_DEPTH 32
+
+// One `let` or parameter in scope, or a scope start when name is SYMBOL_NONE.
+// The grammar has no assignment, so a constant binding stays constant
+typedef struct {
+    Symbol name;
+    int shadowed;       // Binding of the same name underneath, or -1
+    bool constant;
+    bool referenced;    // Used where the value cannot replace the name
+    int opaque_seen;    // Folder's opaque count when it was bound
+    int32_t value;
+    ASTNode* decl;      // NODE_VAR_DECL that made it
+} FoldBinding;
+
+typedef struct {
+    Arena* arena;
+    FoldBinding* bindings;
+    int count;
+    int capacity;
+    int* innermost;     // Binding each symbol resolves to, or -1
+    int symbol_capacity;
+    int floor;          // Bindings below this are out of sight
+    int opaque_seen;    // Nodes whose children the walk cannot see
+    Symbol minus;
+} Folder;
+
+static const AstVisitor folder_visitor;
+
+// ============================================================================
+// CONSTANTS
+// ============================================================================
+
+// Decimal literals only: a leading zero would be octal in C and not in
+// Rust, and a '.' makes it a float
+static bool fold_parse_number(Symbol symbol, int32_t* value) {
+    const char* text = symbol_text(symbol);
+    int length = symbol_length(symbol);
+    if (length == 0 || length > 10 || (text[0] == '0' && length > 1)) return false;
+
+    int64_t result = 0;
+    for (int i = 0; i < length; i++) {
+        if (!isdigit((unsigned char)text[i])) return false;
+        result = result * 10 + (text[i] - '0');
+    }
+    if (result > FOLD_MAX) return false;
+
+    *value = (int32_t)result;
+    return true;
+}
+
+// A literal, or the parser's negative form of one
+static bool fold_constant(const ASTNode* node, int32_t* value) {
+    if (node->type == NODE_NUMBER) return fold_parse_number(node->value, value);
+
+    if (node->type == NODE_UNARY_OP && node->op == TOKEN_MINUS &&
+        node->as.operand && node->as.operand->type == NODE_NUMBER &&
+        fold_parse_number(node->as.operand->value, value)) {
+        *value = -*value;
+        return true;
+    }
+    return false;
+}
+
+// Turns node into the literal for value, shaped as the parser would have
+// parsed it
+static void fold_replace(Folder* folder, ASTNode* node, int64_t value) {
+    char digits[16];
+    int length = snprintf(digits, sizeof(digits), "%lld", (long long)(value < 0 ? -value : value));
+    Symbol text = symbol_intern(digits, length);
+
+    if (value >= 0) {
+        node->type = NODE_NUMBER;
+        node->value = text;
+        return;
+    }
+
+    ASTNode* number = ast_create_node(folder->arena, NODE_NUMBER);
+    number->value = text;
+    number->span = node->span;
+
+    node->type = NODE_UNARY_OP;
+    node->op = TOKEN_MINUS;
+    node->value = folder->minus;
+    node->as.operand = number;
+}
+
+// Checked like the targets' arithmetic: overflow, a zero divisor and the
+// one value with no positive literal are all left alone. Division and
+// remainder truncate toward zero in C99 and Rust alike
+static void fold_arithmetic(Folder* folder, ASTNode* node) {
+    int32_t left, right;
+    if (!fold_constant(node->as.binary.left, &left) || !fold_constant(node->as.binary.right, &right)) return;
+
+    int64_t result;
+    switch (node->op) {
+        case TOKEN_PLUS:     result = (int64_t)left + right; break;
+        case TOKEN_MINUS:    result = (int64_t)left - right; break;
+        case TOKEN_MULTIPLY: result = (int64_t)left * right; break;
+        case TOKEN_DIVIDE:
+            if (right == 0) return;
+            result = (int64_t)left / right;
+            break;
+        case TOKEN_MODULO:
+            if (right == 0) return;
+            result = (int64_t)left % right;
+            break;
+        default:
+            return;
+    }
+
+    if (result <= FOLD_MIN || result > FOLD_MAX) return;
+    fold_replace(folder, node, result);
+}
+
+// Whether a condition is known, and which way it goes. Comparisons and
+// logic are judged here but never replaced by literals, since they are int
+// in C and bool in Rust. Short-circuiting is kept: the right side is only
+// looked at when it would run
+static bool fold_truth(const ASTNode* node, int depth, bool* truth) {
+    int32_t value;
+    if (fold_constant(node, &value)) {
+        *truth = value != 0;
+        return true;
+    }
+    if (depth == FOLD_TRUTH_DEPTH) return false;
+
+    if (node->type == NODE_UNARY_OP && node->op == TOKEN_NOT) {
+        if (!node->as.operand || !fold_truth(node->as.operand, depth + 1, truth)) return false;
+        *truth = !*truth;
+        return true;
+    }
+    if (node->type != NODE_BINARY_OP) return false;
+
+    const ASTNode* left = node->as.binary.left;
+    const ASTNode* right = node->as.binary.right;
+    if (!left || !right) return false;
+
+    if (node->op == TOKEN_AND || node->op == TOKEN_OR) {
+        bool first;
+        if (!fold_truth(left, depth + 1, &first)) return false;
+        if (first == (node->op == TOKEN_OR)) {
+            *truth = first;
+            return true;
+        }
+        return fold_truth(right, depth + 1, truth);
+    }
+
+    int32_t a, b;
+    if (!fold_constant(left, &a) || !fold_constant(right, &b)) return false;
+
+    switch (node->op) {
+        case TOKEN_EQUAL:         *truth = a == b; return true;
+        case TOKEN_NOT_EQUAL:     *truth = a != b; return true;
+        case TOKEN_LESS:          *truth = a < b;  return true;
+        case TOKEN_GREATER:       *truth = a > b;  return true;
+        case TOKEN_LESS_EQUAL:    *truth = a <= b; return true;
+        case TOKEN_GREATER_EQUAL: *truth = a >= b; return true;
+        default:                  return false;
+    }
+}
+
+// ============================================================================
+// SCOPES
+// ============================================================================
+
+static void fold_bind(Folder* folder, Symbol name, ASTNode* decl) {
+    if (folder->count == folder->capacity) {
+        folder->capacity = folder->capacity ? folder->capacity * 2 : 64;
+        folder->bindings = realloc(folder->bindings, sizeof(FoldBinding) * folder->capacity);
+    }
+
+    if (name != SYMBOL_NONE && (int)name >= folder->symbol_capacity) {
+        int capacity = folder->symbol_capacity ? folder->symbol_capacity : 256;
+        while (capacity <= (int)name) capacity *= 2;
+        folder->innermost = realloc(folder->innermost, sizeof(int) * capacity);
+        for (int i = folder->symbol_capacity; i < capacity; i++) folder->innermost[i] = -1;
+        folder->symbol_capacity = capacity;
+    }
+
+    FoldBinding* binding = &folder->bindings[folder->count];
+    *binding = (FoldBinding){name, -1, false, false, folder->opaque_seen, 0, decl};
+
+    if (name != SYMBOL_NONE) {
+        binding->shadowed = folder->innermost[name];
+        folder->innermost[name] = folder->count;
+    }
+
+    // A missing initializer is emitted as 0
+    if (decl) {
+        binding->constant = decl->as.operand ? fold_constant(decl->as.operand, &binding->value) : true;
+    }
+    folder->count++;
+}
+
+static FoldBinding* fold_lookup(Folder* folder, Symbol name) {
+    if ((int)name >= folder->symbol_capacity) return NULL;
+    int index = folder->innermost[name];
+    return index >= folder->floor ? &folder->bindings[index] : NULL;
+}
+
+static void fold_open_scope(Folder* folder) {
+    fold_bind(folder, SYMBOL_NONE, NULL);
+}
+
+// Ends the innermost scope. A constant every use of which was replaced
+// needs no declaration, unless something the walk could not look into
+// came by while it was in scope; its node is emptied for the enclosing
+// block to drop
+static void fold_close_scope(Folder* folder) {
+    while (folder->count > 0) {
+        FoldBinding* binding = &folder->bindings[--folder->count];
+        if (binding->name == SYMBOL_NONE) break;
+
+        folder->innermost[binding->name] = binding->shadowed;
+        if (binding->constant && !binding->referenced && binding->opaque_seen == folder->opaque_seen) {
+            binding->decl->type = NODE_PROGRAM;
+            binding->decl->as.list.count = 0;
+        }
+    }
+}
+
+// Instruction bodies see none of the program's names; their parameters
+// are kept out of the tree
+static void fold_isolated(Folder* folder, ASTNode* root) {
+    int floor = folder->floor;
+    folder->floor = folder->count;
+    ast_walk(root, &folder_visitor, folder);
+    folder->floor = floor;
+}
+
+// ============================================================================
+// BLOCKS
+// ============================================================================
+
+// Whether making a block's statements part of the enclosing one would
+// change what they declare in it
+static bool fold_declares(const ASTNode* block) {
+    if (block->type != NODE_PROGRAM) return false;
+
+    for (int i = 0; i < block->as.list.count; i++) {
+        int type = block->as.list.items[i]->type;
+        if (type == NODE_VAR_DECL || type == NODE_FUNC_DECL) return true;
+    }
+    return false;
+}
+
+// Splices in the blocks that dropped branches and declarations left behind
+static void fold_flatten(Folder* folder, ASTNode* block) {
+    int i = 0;
+    while (i < block->as.list.count && block->as.list.items[i]->type != NODE_PROGRAM) i++;
+    if (i == block->as.list.count) return;
+
+    ASTNode* flat = ast_create_list_node(folder->arena, NODE_PROGRAM);
+    for (i = 0; i < block->as.list.count; i++) {
+        ASTNode* item = block->as.list.items[i];
+        if (item->type != NODE_PROGRAM) {
+            ast_list_append(folder->arena, flat, item);
+            continue;
+        }
+        for (int j = 0; j < item->as.list.count; j++) {
+            ast_list_append(folder->arena, flat, item->as.list.items[j]);
+        }
+    }
+
+    block->as.list.items = flat->as.list.items;
+    block->as.list.count = flat->as.list.count;
+}
+
+// Replaces an if whose condition is known by the branch that runs. An
+// empty else goes first; a branch that declares names is only spliced
+// where it stays a block of its own, as the else of another if
+static void fold_branch(AstWalk* walk, ASTNode* node) {
+    ASTNode** branch = node->as.list.items;
+
+    if (node->as.list.count == 3 && branch[IF_ELSE]->type == NODE_PROGRAM &&
+        branch[IF_ELSE]->as.list.count == 0) {
+        node->as.list.count = 2;
+    }
+
+    bool taken;
+    if (!branch[IF_CONDITION] || !fold_truth(branch[IF_CONDITION], 0, &taken)) return;
+
+    ASTNode* live = taken ? branch[IF_THEN] : node->as.list.count == 3 ? branch[IF_ELSE] : NULL;
+    ASTNode* parent = ast_walk_ancestor(walk, 1);
+    bool own_block = parent && parent->type == NODE_IF_STMT;
+
+    if (live && live->type == NODE_PROGRAM && live->as.list.count == 0) live = NULL;
+
+    if (live && !own_block && fold_declares(live)) {
+        if (taken) node->as.list.count = 2;
+        return;
+    }
+
+    if (live) {
+        *node = *live;
+    } else {
+        node->type = NODE_PROGRAM;
+        node->as.list.count = 0;
+    }
+}
+
+// ============================================================================
+// PASS
+// ============================================================================
+
+static VisitAction folder_enter(AstWalk* walk, ASTNode* node) {
+    Folder* folder = walk->context;
+
+    switch (node->type) {
+        case NODE_PROGRAM:
+            fold_open_scope(folder);
+            break;
+
+        case NODE_FUNC_DECL: {
+            fold_open_scope(folder);
+            ASTNode* params = node->as.function.params;
+            for (int i = 0; params && i < params->as.list.count; i++) {
+                fold_bind(folder, params->as.list.items[i]->value, NULL);
+            }
+            break;
+        }
+
+        case NODE_PROGRAM_DECL:
+            // Its declarations are not children the walk would visit
+            fold_open_scope(folder);
+            for (int i = 0; i < node->as.list.count; i++) {
+                ast_walk(node->as.list.items[i], &folder_visitor, folder);
+            }
+            break;
+
+        case NODE_INSTRUCTION_DECL:
+            // Its parameters' space and seeds expressions may name the
+            // program's constants, and the walk does not see them
+            folder->opaque_seen++;
+            if (node->as.instruction.body) fold_isolated(folder, node->as.instruction.body);
+            break;
+
+        default:
+            // Solana statements keep their expressions out of the walk
+            if (node->type > NODE_MEMBER_ACCESS) folder->opaque_seen++;
+            break;
+    }
+    return VISIT_CONTINUE;
+}
+
+static VisitAction folder_before(AstWalk* walk, ASTNode* parent, ASTNode* child, int index) {
+    (void)walk;
+    (void)child;
+
+    // Parameters were bound on entering the function
+    return parent->type == NODE_FUNC_DECL && index == 0 ? VISIT_SKIP : VISIT_CONTINUE;
+}
+
+static VisitAction folder_leave(AstWalk* walk, ASTNode* node) {
+    Folder* folder = walk->context;
+
+    switch (node->type) {
+        case NODE_IDENTIFIER: {
+            FoldBinding* binding = fold_lookup(folder, node->value);
+            if (!binding || !binding->constant) break;
+
+            // `5.field` would not parse again
+            ASTNode* parent = ast_walk_ancestor(walk, 1);
+            if (parent && parent->type == NODE_MEMBER_ACCESS) {
+                binding->referenced = true;
+            } else {
+                fold_replace(folder, node, binding->value);
+            }
+            break;
+        }
+
+        case NODE_UNARY_OP: {
+            // `-(-5)` and the like; a plain `-5` is already in shape
+            int32_t value;
+            if (node->op == TOKEN_MINUS && node->as.operand &&
+                node->as.operand->type == NODE_UNARY_OP &&
+                fold_constant(node->as.operand, &value) && value > FOLD_MIN) {
+                fold_replace(folder, node, -(int64_t)value);
+            }
+            break;
+        }
+
+        case NODE_BINARY_OP:
+            if (node->as.binary.left && node->as.binary.right) fold_arithmetic(folder, node);
+            break;
+
+        case NODE_VAR_DECL:
+            fold_bind(folder, node->value, node);
+            break;
+
+        case NODE_IF_STMT:
+            fold_branch(walk, node);
+            break;
+
+        case NODE_PROGRAM:
+        case NODE_PROGRAM_DECL:
+            fold_close_scope(folder);
+            fold_flatten(folder, node);
+            break;
+
+        case NODE_FUNC_DECL:
+            fold_close_scope(folder);
+            break;
+
+        default:
+            break;
+    }
+    return VISIT_CONTINUE;
+}
+
+static const AstVisitor folder_visitor = {folder_enter, folder_before, NULL, folder_leave};
+
+// Runs once the tree has parsed without errors. New nodes come from arena;
+// the symbol table must not be shared at the time
+void ast_fold(Arena* arena, ASTNode* root) {
+    Folder folder = {0};
+    folder.arena = arena;
+    folder.minus = symbol_intern("-", 1);
+
+    ast_walk(root, &folder_visitor, &folder);
+
+    free(folder.bindings);
+    free(folder.innermost);
+}
@@ -0,0 +1,236 @@
+/*
+ * so_lang_intern.c - So Lang String Interner
+ * Unique byte strings live once in an arena; everything else holds a Symbol
+ */
+
+#include <pthread.h>
+
+#include "so_lang.h"
+
+// Strings are copied into chunks of this size; longer ones get their own
+#define SYMBOL_CHUNK_SIZE (64 * 1024)
+#define SYMBOL_INITIAL_SLOTS 1024
+#define SYMBOL_CACHE_SIZE 256
+
+typedef struct SymbolChunk {
+    struct SymbolChunk* next;
+    size_t used;
+    size_t capacity;
+    char data[];
+} SymbolChunk;
+
+typedef struct {
+    const char* text;   // NUL-terminated, stable for the interner's lifetime
+    uint32_t length;
+    uint32_t hash;
+} SymbolEntry;
+
+// Open addressing with linear probing; a zero slot is empty, which is free
+// because SYMBOL_NONE (the empty string) never goes through the table
+static struct {
+    SymbolEntry* entries;
+    uint32_t count;
+    uint32_t capacity;
+    uint32_t* slots;
+    uint32_t slot_mask;
+    SymbolChunk* chunks;
+} table;
+
+// While parser threads run, the table is behind a lock. Each thread keeps a
+// small direct-mapped cache of names it has seen, so it takes the lock about
+// once per distinct name rather than once per identifier
+static bool table_shared;
+static pthread_mutex_t table_lock = PTHREAD_MUTEX_INITIALIZER;
+
+// Bumped whenever ids stop meaning what a cache remembers
+static uint32_t table_generation = 1;
+
+typedef struct {
+    const char* text;
+    uint32_t length;
+    uint32_t generation;
+    Symbol id;
+} SymbolCacheEntry;
+
+static __thread SymbolCacheEntry symbol_cache[SYMBOL_CACHE_SIZE];
+
+// ============================================================================
+// INTERNALS
+// ============================================================================
+
+static uint64_t symbol_load(const char* text, int length) {
+    uint64_t word = 0;
+    memcpy(&word, text, length);
+    return word;
+}
+
+static uint64_t symbol_mix(uint64_t hash, uint64_t word) {
+    hash = (hash ^ word) * 0xff51afd7ed558ccdull;
+    return hash ^ (hash >> 32);
+}
+
+// A word at a time: every identifier is hashed as it is lexed, and a
+// byte-wise loop made that most of the cost of interning it. The tail is
+// read as one overlapping word, or in two halves when the name is short
+static uint32_t symbol_hash(const char* text, int length) {
+    uint64_t hash = 0x9e3779b97f4a7c15ull ^ (uint64_t)length;
+    int rest = length;
+
+    for (; rest > 8; rest -= 8, text += 8) {
+        hash = symbol_mix(hash, symbol_load(text, 8));
+    }
+
+    if (length >= 8) {
+        hash = symbol_mix(hash, symbol_load(text + rest - 8, 8));
+    } else if (rest >= 4) {
+        hash = symbol_mix(hash, symbol_load(text, 4) << 32 | symbol_load(text + rest - 4, 4));
+    } else if (rest > 0) {
+        hash = symbol_mix(hash, symbol_load(text, 1) << 16 | symbol_load(text + rest / 2, 1) << 8 |
+                                symbol_load(text + rest - 1, 1));
+    }
+
+    hash *= 0xc4ceb9fe1a85ec53ull;
+    return (uint32_t)(hash ^ (hash >> 29));
+}
+
+static void symbol_table_init(void) {
+    table.capacity = SYMBOL_INITIAL_SLOTS / 2;
+    table.entries = malloc(sizeof(SymbolEntry) * table.capacity);
+    table.entries[SYMBOL_NONE] = (SymbolEntry){"", 0, 0};
+    table.count = 1;
+    table.slot_mask = SYMBOL_INITIAL_SLOTS - 1;
+    table.slots = calloc(SYMBOL_INITIAL_SLOTS, sizeof(uint32_t));
+}
+
+static const char* symbol_store(const char* text, int length) {
+    size_t needed = (size_t)length + 1;
+    SymbolChunk* chunk = table.chunks;
+
+    if (!chunk || chunk->capacity - chunk->used < needed) {
+        size_t capacity = needed > SYMBOL_CHUNK_SIZE ? needed : SYMBOL_CHUNK_SIZE;
+        chunk = malloc(sizeof(SymbolChunk) + capacity);
+        chunk->used = 0;
+        chunk->capacity = capacity;
+
+        // Keep the roomier chunk at the head so one long string does not
+        // strand the free space left in the current one
+        if (table.chunks && capacity == needed) {
+            chunk->next = table.chunks->next;
+            table.chunks->next = chunk;
+        } else {
+            chunk->next = table.chunks;
+            table.chunks = chunk;
+        }
+    }
+
+    char* copy = chunk->data + chunk->used;
+    memcpy(copy, text, length);
+    copy[length] = '\0';
+    chunk->used += needed;
+    return copy;
+}
+
+// Doubles the slot array once it is half full
+static void symbol_table_grow(void) {
+    uint32_t slot_count = (table.slot_mask + 1) * 2;
+    uint32_t* slots = calloc(slot_count, sizeof(uint32_t));
+    uint32_t mask = slot_count - 1;
+
+    for (uint32_t id = 1; id < table.count; id++) {
+        uint32_t i = table.entries[id].hash & mask;
+        while (slots[i]) i = (i + 1) & mask;
+        slots[i] = id;
+    }
+
+    free(table.slots);
+    table.slots = slots;
+    table.slot_mask = mask;
+
+    table.capacity = slot_count / 2;
+    table.entries = realloc(table.entries, sizeof(SymbolEntry) * table.capacity);
+}
+
+static Symbol symbol_insert(const char* text, int length, uint32_t hash) {
+    if (!table.slots) symbol_table_init();
+
+    uint32_t i = hash & table.slot_mask;
+
+    for (uint32_t id; (id = table.slots[i]) != 0; i = (i + 1) & table.slot_mask) {
+        const SymbolEntry* entry = &table.entries[id];
+        if (entry->hash == hash && entry->length == (uint32_t)length &&
+            memcmp(entry->text, text, length) == 0) {
+            return id;
+        }
+    }
+
+    if (table.count == table.capacity) {
+        symbol_table_grow();
+        i = hash & table.slot_mask;
+        while (table.slots[i]) i = (i + 1) & table.slot_mask;
+    }
+
+    Symbol id = table.count++;
+    table.entries[id] = (SymbolEntry){symbol_store(text, length), (uint32_t)length, hash};
+    table.slots[i] = id;
+    return id;
+}
+
+static Symbol symbol_intern_shared(const char* text, int length, uint32_t hash) {
+    SymbolCacheEntry* cached = &symbol_cache[hash & (SYMBOL_CACHE_SIZE - 1)];
+    if (cached->generation == table_generation && cached->length == (uint32_t)length &&
+        memcmp(cached->text, text, length) == 0) {
+        return cached->id;
+    }
+
+    pthread_mutex_lock(&table_lock);
+    Symbol id = symbol_insert(text, length, hash);
+    // Stored text never moves, so the cache may keep pointing at it
+    *cached = (SymbolCacheEntry){table.entries[id].text, (uint32_t)length, table_generation, id};
+    pthread_mutex_unlock(&table_lock);
+    return id;
+}
+
+// ============================================================================
+// PUBLIC API
+// ============================================================================
+
+Symbol symbol_intern(const char* text, int length) {
+    if (length == 0) return SYMBOL_NONE;
+
+    uint32_t hash = symbol_hash(text, length);
+    if (table_shared) return symbol_intern_shared(text, length, hash);
+    return symbol_insert(text, length, hash);
+}
+
+// Interning is safe from several threads while shared; symbol_text and
+// symbol_length are not, as the entry array may move underneath them
+void symbol_table_set_shared(bool shared) {
+    table_shared = shared;
+}
+
+const char* symbol_text(Symbol symbol) {
+    return symbol == SYMBOL_NONE ? "" : table.entries[symbol].text;
+}
+
+int symbol_length(Symbol symbol) {
+    return symbol == SYMBOL_NONE ? 0 : (int)table.entries[symbol].length;
+}
+
+// Identifiers and strings were interned by the lexer; anything else
+// (numbers, operators) is interned from its source slice
+Symbol token_symbol(const char* source, const Token* token) {
+    if (token->symbol != SYMBOL_NONE) return token->symbol;
+    return symbol_intern(source + token->start, token->length);
+}
+
+void symbol_table_free(void) {
+    while (table.chunks) {
+        SymbolChunk* next = table.chunks->next;
+        free(table.chunks);
+        table.chunks = next;
+    }
+    free(table.entries);
+    free(table.slots);
+    memset(&table, 0, sizeof(table));
+    table_generation++;
+}
@@ -0,0 +1,74 @@
+/*
+ * so_lang_keywords.h - So Lang Keyword Table
+ * Generated by scripts/gen-keywords.py - do not edit by hand
+ */
+
+#ifndef SO_LANG_KEYWORDS_H
+#define SO_LANG_KEYWORDS_H
+
+#include "so_lang.h"
+
+// Keyword sets; each lexer passes the sets its dialect recognizes
+#define KEYWORD_CORE       0x1
+#define KEYWORD_SOLANA     0x2
+#define KEYWORD_SOLANA_EXT 0x4
+#define KEYWORD_ATTRIBUTE  0x8
+
+#define KEYWORD_MIN_LEN 2
+#define KEYWORD_MAX_LEN 11
+#define KEYWORD_TABLE_SIZE 64
+
+// Collision-free over every keyword, so a lookup is one probe and one memcmp
+#define KEYWORD_HASH(text, length) \
+    (((unsigned char)(text)[0] * 4u + \
+      (unsigned char)(text)[(length) - 1] * 44u + \
+      (unsigned)(length)) & (KEYWORD_TABLE_SIZE - 1))
+
+typedef struct {
+    const char* name;
+    unsigned char length;
+    unsigned char sets;
+    TokenType type;
+} Keyword;
+
+static const Keyword KEYWORD_TABLE[KEYWORD_TABLE_SIZE] = {
+    [ 0] = {"writable", 8, KEYWORD_SOLANA | KEYWORD_ATTRIBUTE, TOKEN_WRITABLE},
+    [ 2] = {"fn", 2, KEYWORD_CORE, TOKEN_FN},
+    [ 3] = {"program", 7, KEYWORD_SOLANA | KEYWORD_ATTRIBUTE, TOKEN_PROGRAM},
+    [ 6] = {"invoke", 6, KEYWORD_SOLANA_EXT, TOKEN_INVOKE},
+    [ 8] = {"emit", 4, KEYWORD_SOLANA, TOKEN_EMIT},
+    [ 9] = {"event", 5, KEYWORD_SOLANA_EXT, TOKEN_EVENT},
+    [12] = {"bump", 4, KEYWORD_SOLANA, TOKEN_BUMP},
+    [14] = {"entrypoint", 10, KEYWORD_SOLANA_EXT, TOKEN_ENTRYPOINT},
+    [18] = {"pubkey", 6, KEYWORD_SOLANA, TOKEN_PUBKEY},
+    [21] = {"seeds", 5, KEYWORD_SOLANA, TOKEN_SEEDS},
+    [23] = {"instruction", 11, KEYWORD_SOLANA | KEYWORD_ATTRIBUTE, TOKEN_INSTRUCTION},
+    [24] = {"init", 4, KEYWORD_SOLANA | KEYWORD_ATTRIBUTE, TOKEN_INIT},
+    [34] = {"anchor", 6, KEYWORD_SOLANA_EXT, TOKEN_ANCHOR},
+    [35] = {"let", 3, KEYWORD_CORE, TOKEN_LET},
+    [42] = {"signer", 6, KEYWORD_SOLANA | KEYWORD_ATTRIBUTE, TOKEN_SIGNER},
+    [43] = {"require", 7, KEYWORD_SOLANA, TOKEN_REQUIRE},
+    [45] = {"state", 5, KEYWORD_SOLANA, TOKEN_STATE},
+    [46] = {"if", 2, KEYWORD_CORE, TOKEN_IF},
+    [47] = {"pda", 3, KEYWORD_SOLANA_EXT, TOKEN_PDA},
+    [48] = {"transfer", 8, KEYWORD_SOLANA, TOKEN_TRANSFER},
+    [49] = {"error", 5, KEYWORD_SOLANA_EXT, TOKEN_ERROR},
+    [52] = {"else", 4, KEYWORD_CORE, TOKEN_ELSE},
+    [53] = {"print", 5, KEYWORD_CORE, TOKEN_PRINT},
+    [54] = {"return", 6, KEYWORD_CORE, TOKEN_RETURN},
+    [59] = {"account", 7, KEYWORD_SOLANA | KEYWORD_ATTRIBUTE, TOKEN_ACCOUNT},
+    [60] = {"lamports", 8, KEYWORD_SOLANA_EXT, TOKEN_LAMPORTS},
+    [62] = {"solana", 6, KEYWORD_SOLANA_EXT, TOKEN_SOLANA},
+};
+
+static inline TokenType keyword_lookup(const char* text, int length, unsigned sets) {
+    if (length < KEYWORD_MIN_LEN || length > KEYWORD_MAX_LEN) return TOKEN_IDENTIFIER;
+    const Keyword* keyword = &KEYWORD_TABLE[KEYWORD_HASH(text, length)];
+    if (keyword->length == length && (keyword->sets & sets) &&
+        memcmp(keyword->name, text, length) == 0) {
+        return keyword->type;
+    }
+    return TOKEN_IDENTIFIER;
+}
+
+#endif
@@ -0,0 +1,364 @@
+/*
+ * so_lang_lexer.c - So Lang Shared Table-Driven Lexer
+ * One tokenizer for every frontend; the dialect only picks keyword sets
+ * and whether '@name' is read as an attribute
+ */
+
+#include "so_lang.h"
+#include "so_lang_keywords.h"
+#include "so_lang_scan.h"
+
+// ============================================================================
+// DISPATCH TABLES
+// ============================================================================
+
+// What the first byte of a token starts
+enum {
+    LEX_INVALID,
+    LEX_SPACE,
+    LEX_NEWLINE,
+    LEX_STRING,
+    LEX_IDENT,
+    LEX_NUMBER,
+    LEX_OPERATOR,
+    LEX_SLASH,      // Comment or '/'
+    LEX_AT          // Attribute or '@'
+};
+
+#define _ LEX_INVALID
+#define S LEX_SPACE
+#define N LEX_NEWLINE
+#define Q LEX_STRING
+#define A LEX_IDENT
+#define D LEX_NUMBER
+#define O LEX_OPERATOR
+#define L LEX_SLASH
+#define T LEX_AT
+
+static const unsigned char lex_class[256] = {
+    _, _, _, _, _, _, _, _, _, S, N, S, S, S, _, _,
+    _, _, _, _, _, _, _, _, _, _, _, _, _, _, _, _,
+    S, O, Q, O, _, O, O, _, O, O, O, O, O, O, O, L,
+    D, D, D, D, D, D, D, D, D, D, O, O, O, O, O, _,
+    T, A, A, A, A, A, A, A, A, A, A, A, A, A, A, A,
+    A, A, A, A, A, A, A, A, A, A, A, O, _, O, _, A,
+    _, A, A, A, A, A, A, A, A, A, A, A, A, A, A, A,
+    A, A, A, A, A, A, A, A, A, A, A, O, O, O, _, _,
+    _, _, _, _, _, _, _, _, _, _, _, _, _, _, _, _,
+    _, _, _, _, _, _, _, _, _, _, _, _, _, _, _, _,
+    _, _, _, _, _, _, _, _, _, _, _, _, _, _, _, _,
+    _, _, _, _, _, _, _, _, _, _, _, _, _, _, _, _,
+    _, _, _, _, _, _, _, _, _, _, _, _, _, _, _, _,
+    _, _, _, _, _, _, _, _, _, _, _, _, _, _, _, _,
+    _, _, _, _, _, _, _, _, _, _, _, _, _, _, _, _,
+    _, _, _, _, _, _, _, _, _, _, _, _, _, _, _, _,
+};
+
+#undef _
+#undef S
+#undef N
+#undef Q
+#undef A
+#undef D
+#undef O
+#undef L
+#undef T
+
+// Operator transitions: the first byte selects a state, and the second byte
+// either matches `next` and yields the two-byte token or leaves `single`.
+// TOKEN_EOF as `single` marks a byte that is not a token on its own.
+// Byte-sized fields keep the whole table in a few cache lines.
+typedef struct {
+    unsigned char single;   // TokenType
+    char next;
+    unsigned char pair;     // TokenType
+} OperatorState;
+
+static const OperatorState operator_table[256] = {
+    ['='] = {TOKEN_ASSIGN,    '=', TOKEN_EQUAL},
+    ['!'] = {TOKEN_NOT,       '=', TOKEN_NOT_EQUAL},
+    ['<'] = {TOKEN_LESS,      '=', TOKEN_LESS_EQUAL},
+    ['>'] = {TOKEN_GREATER,   '=', TOKEN_GREATER_EQUAL},
+    ['-'] = {TOKEN_MINUS,     '>', TOKEN_ARROW},
+    ['+'] = {TOKEN_PLUS,      0,   TOKEN_EOF},
+    ['*'] = {TOKEN_MULTIPLY,  0,   TOKEN_EOF},
+    ['/'] = {TOKEN_DIVIDE,    0,   TOKEN_EOF},
+    ['%'] = {TOKEN_MODULO,    0,   TOKEN_EOF},
+    ['&'] = {TOKEN_EOF,       '&', TOKEN_AND},
+    ['|'] = {TOKEN_EOF,       '|', TOKEN_OR},
+    ['('] = {TOKEN_LPAREN,    0,   TOKEN_EOF},
+    [')'] = {TOKEN_RPAREN,    0,   TOKEN_EOF},
+    ['{'] = {TOKEN_LBRACE,    0,   TOKEN_EOF},
+    ['}'] = {TOKEN_RBRACE,    0,   TOKEN_EOF},
+    ['['] = {TOKEN_LBRACKET,  0,   TOKEN_EOF},
+    [']'] = {TOKEN_RBRACKET,  0,   TOKEN_EOF},
+    [','] = {TOKEN_COMMA,     0,   TOKEN_EOF},
+    [';'] = {TOKEN_SEMICOLON, 0,   TOKEN_EOF},
+    [':'] = {TOKEN_COLON,     ':', TOKEN_DOUBLE_COLON},
+    ['.'] = {TOKEN_DOT,       0,   TOKEN_EOF},
+    ['#'] = {TOKEN_HASH,      0,   TOKEN_EOF},
+    ['@'] = {TOKEN_AT_SYMBOL, 0,   TOKEN_EOF},
+};
+
+static const unsigned dialect_keywords[] = {
+    [LEXER_DIALECT_CORE]   = KEYWORD_CORE,
+    [LEXER_DIALECT_SOLANA] = KEYWORD_CORE | KEYWORD_SOLANA | KEYWORD_SOLANA_EXT,
+};
+
+// ============================================================================
+// LEXER IMPLEMENTATION
+// ============================================================================
+
+Lexer* lexer_create(char* source, LexerDialect dialect) {
+    return lexer_create_range(source, 0, (int)strlen(source), dialect);
+}
+
+// Scans only [start, end) of source; token offsets stay relative to source
+Lexer* lexer_create_range(char* source, int start, int end, LexerDialect dialect) {
+    Lexer* lexer = malloc(sizeof(Lexer));
+    lexer->source = source;
+    lexer->cur = source + start;
+    lexer->end = source + end;
+    lexer->dialect = dialect;
+    lexer->keyword_sets = dialect_keywords[dialect];
+    lexer->ring_head = 0;
+    lexer->token_count = 0;
+    lexer->finished = false;
+    lexer->tokens = NULL;
+    lexer->token_capacity = 0;
+    return lexer;
+}
+
+// Drops any lookahead and continues scanning at offset; used to step over
+// a range that was parsed elsewhere
+void lexer_seek(Lexer* lexer, int offset) {
+    lexer->cur = lexer->source + offset;
+    lexer->ring_head = lexer->token_count;
+    lexer->finished = false;
+}
+
+static Token* lexer_add_token(Lexer* lexer, TokenType type, const char* start, int length) {
+    Token* token = &lexer->ring[lexer->token_count++ & LEXER_RING_MASK];
+    token->type = type;
+    token->start = (int)(start - lexer->source);
+    token->length = length;
+    token->symbol = SYMBOL_NONE;
+    return token;
+}
+
+static void lexer_skip_whitespace(Lexer* lexer) {
+    lexer->cur = scan_whitespace(lexer->cur, lexer->end);
+}
+
+// Skips a '//' line comment or a '/* */' block comment; cur is on the '/'
+// and the second character is inside the range
+static void lexer_skip_comment(Lexer* lexer) {
+    const char* p = lexer->cur + 2;
+
+    if (lexer->cur[1] == '/') {
+        // The '\n' is left for the NEWLINE token
+        const char* newline = memchr(p, '\n', lexer->end - p);
+        lexer->cur = newline ? newline : lexer->end;
+        return;
+    }
+
+    // With no newlines to count, only '*' needs a closer look
+    while (p < lexer->end) {
+        p = memchr(p, '*', lexer->end - p);
+        if (!p) {
+            p = lexer->end;
+            break;
+        }
+        if (p + 1 < lexer->end && p[1] == '/') break;
+        p++;
+    }
+
+    if (p < lexer->end) {
+        p += 2; // Skip '*/'
+    } else {
+        diag_report(DIAG_UNTERMINATED_COMMENT, (int)(lexer->cur - lexer->source), 2,
+                    "Unterminated block comment");
+    }
+    lexer->cur = p;
+}
+
+// Escape sequences stay in the slice verbatim; C and Rust share their syntax
+static void lexer_read_string(Lexer* lexer) {
+    const char* start = lexer->cur + 1; // Skip opening quote
+    const char* end = lexer->end;
+
+    const char* p = scan_string(start, end);
+    while (p < end && *p == '\\') {
+        p = scan_string(p + 2 < end ? p + 2 : end, end);
+    }
+
+    Token* token = lexer_add_token(lexer, TOKEN_STRING, start, (int)(p - start));
+    token->symbol = symbol_intern(start, token->length);
+
+    if (p < end) {
+        p++; // Skip closing quote
+    } else {
+        diag_report(DIAG_UNTERMINATED_STRING, (int)(lexer->cur - lexer->source), 1,
+                    "Unterminated string literal");
+    }
+    lexer->cur = p;
+}
+
+// `skip` bytes of prefix ('@' for attributes) are left out of the slice
+static void lexer_read_identifier(Lexer* lexer, int skip, unsigned sets) {
+    const char* start = lexer->cur + skip;
+    const char* p = scan_identifier(start, lexer->end);
+
+    int length = (int)(p - start);
+    lexer->cur = p;
+
+    TokenType type = keyword_lookup(start, length, sets);
+    Token* token = lexer_add_token(lexer, type, start, length);
+    if (type == TOKEN_IDENTIFIER) {
+        token->symbol = symbol_intern(start, length);
+    }
+}
+
+static void lexer_read_number(Lexer* lexer) {
+    const char* start = lexer->cur;
+    const char* p = start;
+    bool has_dot = false;
+
+    while (p < lexer->end) {
+        if (*p == '.' && !has_dot) {
+            has_dot = true;
+        } else if (!is_digit_char(*p)) {
+            break;
+        }
+        p++;
+    }
+
+    lexer->cur = p;
+
+    lexer_add_token(lexer, TOKEN_NUMBER, start, (int)(p - start));
+}
+
+static void lexer_read_operator(Lexer* lexer) {
+    const OperatorState* state = &operator_table[(unsigned char)*lexer->cur];
+    int length = 1;
+
+    if (state->next && lexer->cur + 1 < lexer->end && lexer->cur[1] == state->next) {
+        lexer_add_token(lexer, (TokenType)state->pair, lexer->cur, 2);
+        length = 2;
+    } else if (state->single != TOKEN_EOF) {
+        lexer_add_token(lexer, (TokenType)state->single, lexer->cur, 1);
+    } else {
+        diag_report(DIAG_UNEXPECTED_CHARACTER, (int)(lexer->cur - lexer->source), 1,
+                    "Unexpected character");
+    }
+
+    lexer->cur += length;
+}
+
+// Scans until one more token is in the ring; EOF once the input runs out
+static void lexer_scan(Lexer* lexer) {
+    int produced = lexer->token_count;
+
+    while (lexer->token_count == produced) {
+        if (lexer->cur >= lexer->end) {
+            lexer_add_token(lexer, TOKEN_EOF, lexer->end, 0);
+            lexer->finished = true;
+            break;
+        }
+
+        switch (lex_class[(unsigned char)*lexer->cur]) {
+            case LEX_SPACE:
+                lexer_skip_whitespace(lexer);
+                break;
+            case LEX_NEWLINE:
+                lexer_add_token(lexer, TOKEN_NEWLINE, lexer->cur, 1);
+                lexer->cur++;
+                break;
+            case LEX_STRING:
+                lexer_read_string(lexer);
+                break;
+            case LEX_IDENT:
+                lexer_read_identifier(lexer, 0, lexer->keyword_sets);
+                break;
+            case LEX_NUMBER:
+                lexer_read_number(lexer);
+                break;
+            case LEX_SLASH:
+                // A range may end on the '/', with the next byte not its own
+                if (lexer->cur + 1 < lexer->end && (lexer->cur[1] == '/' || lexer->cur[1] == '*')) {
+                    lexer_skip_comment(lexer);
+                } else {
+                    lexer_read_operator(lexer);
+                }
+                break;
+            case LEX_AT:
+                if (lexer->dialect == LEXER_DIALECT_SOLANA && lexer->cur + 1 < lexer->end &&
+                    is_alpha_char(lexer->cur[1])) {
+                    lexer_read_identifier(lexer, 1, KEYWORD_ATTRIBUTE);
+                } else {
+                    lexer_read_operator(lexer);
+                }
+                break;
+            case LEX_OPERATOR:
+                lexer_read_operator(lexer);
+                break;
+            default:
+                diag_report(DIAG_UNEXPECTED_CHARACTER, (int)(lexer->cur - lexer->source), 1,
+                            "Unexpected character");
+                lexer->cur++;
+                break;
+        }
+    }
+}
+
+// Token n places ahead of the next one (n < LEXER_RING_SIZE). Past the end
+// this is the EOF token. Pointers stay valid until the ring wraps around.
+Token* lexer_peek(Lexer* lexer, int n) {
+    while (lexer->token_count - lexer->ring_head <= n && !lexer->finished) {
+        lexer_scan(lexer);
+    }
+
+    int index = lexer->ring_head + n;
+    if (index >= lexer->token_count) {
+        index = lexer->token_count - 1;
+    }
+    return &lexer->ring[index & LEXER_RING_MASK];
+}
+
+// Consumes the next token; EOF is returned repeatedly once reached
+Token* lexer_next_token(Lexer* lexer) {
+    Token* token = lexer_peek(lexer, 0);
+    if (token->type != TOKEN_EOF) {
+        lexer->ring_head++;
+    }
+    return token;
+}
+
+// Batch mode: drains the whole stream into lexer->tokens
+void lexer_tokenize(Lexer* lexer) {
+    int count = 0;
+
+    for (;;) {
+        Token* token = lexer_next_token(lexer);
+
+        if (count == lexer->token_capacity) {
+            int capacity = count ? count * 2 : INITIAL_TOKEN_CAPACITY;
+            Token* tokens = realloc(lexer->tokens, sizeof(Token) * capacity);
+            if (!tokens) {
+                diag_report(DIAG_OUT_OF_MEMORY, (int)(lexer->cur - lexer->source), 0,
+                            "Out of memory for tokens");
+                return;
+            }
+            lexer->tokens = tokens;
+            lexer->token_capacity = capacity;
+        }
+
+        lexer->tokens[count++] = *token;
+        if (token->type == TOKEN_EOF) break;
+    }
+}
+
+void lexer_free(Lexer* lexer) {
+    free(lexer->tokens);
+    free(lexer);
+}
@@ -0,0 +1,63 @@
+/*
+ * so_lang_lines.c - So Lang Line Index
+ * Tokens and nodes only carry byte offsets; this maps an offset back to
+ * line:column, scanning the source once on the first lookup
+ */
+
+#include "so_lang.h"
+
+void line_index_init(LineIndex* index, const char* source) {
+    index->source = source;
+    index->line_starts = NULL;
+    index->line_count = 0;
+}
+
+static bool line_index_build(LineIndex* index) {
+    const char* source = index->source;
+    const char* end = source + strlen(source);
+
+    int lines = 1;
+    for (const char* p = source; (p = memchr(p, '\n', end - p)) != NULL; p++) {
+        lines++;
+    }
+
+    int* starts = malloc(sizeof(int) * lines);
+    if (!starts) return false;
+
+    starts[0] = 0;
+    int count = 1;
+    for (const char* p = source; (p = memchr(p, '\n', end - p)) != NULL; p++) {
+        starts[count++] = (int)(p + 1 - source);
+    }
+
+    index->line_starts = starts;
+    index->line_count = count;
+    return true;
+}
+
+// Both 1-based; the column counts bytes, as the lexer always has
+SourceLocation line_index_locate(LineIndex* index, int offset) {
+    if (!index->line_starts && !line_index_build(index)) {
+        return (SourceLocation){0, 0};
+    }
+
+    // Last line starting at or before offset
+    int low = 0;
+    int high = index->line_count - 1;
+    while (low < high) {
+        int mid = low + (high - low + 1) / 2;
+        if (index->line_starts[mid] <= offset) {
+            low = mid;
+        } else {
+            high = mid - 1;
+        }
+    }
+
+    return (SourceLocation){low + 1, offset - index->line_starts[low] + 1};
+}
+
+void line_index_free(LineIndex* index) {
+    free(index->line_starts);
+    index->line_starts = NULL;
+    index->line_count = 0;
+}
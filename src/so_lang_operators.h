@@ -0,0 +1,71 @@
+/*
+ * so_lang_operators.h - So Lang Operator Precedence Table
+ * Binding power and associativity of every expression operator, shared by
+ * the precedence-climbing parsers and the emitters that place parentheses
+ */
+
+#ifndef SO_LANG_OPERATORS_H
+#define SO_LANG_OPERATORS_H
+
+#include "so_lang.h"
+
+// Loosest to tightest; PREC_NONE means the token does not continue an expression
+typedef enum {
+    PREC_NONE,
+    PREC_OR,            // ||
+    PREC_AND,           // &&
+    PREC_EQUALITY,      // == !=
+    PREC_COMPARISON,    // < > <= >=
+    PREC_TERM,          // + -
+    PREC_FACTOR,        // * / %
+    PREC_UNARY,         // ! - (prefix)
+    PREC_MEMBER,        // .
+    PREC_PRIMARY        // Literals, names, calls
+} Precedence;
+
+typedef struct {
+    unsigned char precedence;   // Precedence
+    bool right_assoc;
+} OperatorInfo;
+
+// Infix operators, indexed by TokenType
+static const OperatorInfo infix_operators[256] = {
+    [TOKEN_OR]            = {PREC_OR,         false},
+    [TOKEN_AND]           = {PREC_AND,        false},
+    [TOKEN_EQUAL]         = {PREC_EQUALITY,   false},
+    [TOKEN_NOT_EQUAL]     = {PREC_EQUALITY,   false},
+    [TOKEN_LESS]          = {PREC_COMPARISON, false},
+    [TOKEN_GREATER]       = {PREC_COMPARISON, false},
+    [TOKEN_LESS_EQUAL]    = {PREC_COMPARISON, false},
+    [TOKEN_GREATER_EQUAL] = {PREC_COMPARISON, false},
+    [TOKEN_PLUS]          = {PREC_TERM,       false},
+    [TOKEN_MINUS]         = {PREC_TERM,       false},
+    [TOKEN_MULTIPLY]      = {PREC_FACTOR,     false},
+    [TOKEN_DIVIDE]        = {PREC_FACTOR,     false},
+    [TOKEN_MODULO]        = {PREC_FACTOR,     false},
+    [TOKEN_DOT]           = {PREC_MEMBER,     false},
+};
+
+// How tightly the operator at the root of `node` binds
+static inline int ast_precedence(const ASTNode* node) {
+    switch (node->type) {
+        case NODE_BINARY_OP:     return infix_operators[node->op].precedence;
+        case NODE_UNARY_OP:      return PREC_UNARY;
+        case NODE_MEMBER_ACCESS: return PREC_MEMBER;
+        default:                 return PREC_PRIMARY;
+    }
+}
+
+// Whether `child` must be wrapped to keep its place under `parent`: it binds
+// looser, or equally on the side the parent's associativity does not group
+static inline bool ast_needs_parens(const ASTNode* child, const ASTNode* parent, bool right_side) {
+    int child_precedence = ast_precedence(child);
+    int parent_precedence = ast_precedence(parent);
+
+    if (child_precedence != parent_precedence) return child_precedence < parent_precedence;
+
+    bool right_assoc = parent->type == NODE_BINARY_OP && infix_operators[parent->op].right_assoc;
+    return right_side != right_assoc;
+}
+
+#endif // SO_LANG_OPERATORS_H
@@ -0,0 +1,196 @@
+/*
+ * so_lang_parallel.c - So Lang Parallel Parsing Support
+ * Cuts a source range between its top-level declarations with one
+ * vectorized pass, and runs the pieces on a small pool of threads
+ */
+
+#ifndef _DEFAULT_SOURCE
+#define _DEFAULT_SOURCE     // sysconf
+#endif
+
+#include <pthread.h>
+#include <unistd.h>
+
+#include "so_lang.h"
+#include "so_lang_scan.h"
+
+// ============================================================================
+// DECLARATION BOUNDARIES
+// ============================================================================
+
+// Past the closing quote of a string whose body starts at p, with the
+// lexer's escape rule; NULL if it never closes
+static const char* split_skip_string(const char* p, const char* end) {
+    p = scan_string(p, end);
+    while (p < end && *p == '\\') {
+        p = scan_string(p + 2 < end ? p + 2 : end, end);
+    }
+    return p < end ? p + 1 : NULL;
+}
+
+// Past a comment starting at p (on its '/'), or just past a lone '/';
+// NULL for an unterminated block comment
+static const char* split_skip_slash(const char* p, const char* end) {
+    if (p + 1 < end && p[1] == '/') {
+        const char* newline = memchr(p + 2, '\n', end - (p + 2));
+        return newline ? newline : end;
+    }
+
+    if (p + 1 < end && p[1] == '*') {
+        for (p += 2; (p = memchr(p, '*', end - p)) != NULL; p++) {
+            if (p + 1 < end && p[1] == '/') return p + 2;
+        }
+        return NULL;
+    }
+
+    return p + 1;
+}
+
+// Whether the statement closed by the '}' before p goes on (`} else {`).
+// A comment in between is not looked into; the cut is simply not made
+static bool split_continues(const char* p, const char* end) {
+    while (p < end && (is_space_char(*p) || *p == '\n')) p++;
+    if (p < end && *p == '/') return true;
+    return end - p >= 4 && memcmp(p, "else", 4) == 0 && (end - p == 4 || !is_ident_char(p[4]));
+}
+
+static void split_push(DeclarationSplit* split, int* capacity, int offset) {
+    if (split->count + 1 == *capacity) {
+        *capacity *= 2;
+        split->bounds = realloc(split->bounds, sizeof(int) * *capacity);
+    }
+    split->bounds[++split->count] = offset;
+}
+
+// Cuts [start, end) just past '}'s that close a top-level brace, once the
+// piece since the last cut is at least min_chunk bytes. Only braces,
+// strings and comments are looked at. A '}' that closes more than the range
+// opened (a program body's own) stops the scan there. False if the range
+// is unbalanced; the caller then parses it in one piece
+bool split_declarations(const char* source, int start, int end, int min_chunk, DeclarationSplit* split) {
+    const char* p = source + start;
+    const char* limit = source + end;
+    const char* last_cut = p;
+    int depth = 0;
+    int capacity = 16;
+
+    split->bounds = malloc(sizeof(int) * capacity);
+    split->bounds[0] = start;
+    split->count = 0;
+
+    while ((p = scan_structure(p, limit)) < limit) {
+        switch (*p) {
+            case '{':
+                depth++;
+                p++;
+                break;
+            case '}':
+                if (depth == 0) goto done;
+                depth--;
+                p++;
+                if (depth == 0 && p - last_cut >= min_chunk && !split_continues(p, limit)) {
+                    split_push(split, &capacity, (int)(p - source));
+                    last_cut = p;
+                }
+                break;
+            case '"':
+                p = split_skip_string(p + 1, limit);
+                break;
+            default:
+                p = split_skip_slash(p, limit);
+                break;
+        }
+
+        if (!p) {
+            split_free(split);
+            return false;
+        }
+    }
+
+done:
+    split->end = (int)(p - source);
+    if (depth != 0) {
+        split_free(split);
+        return false;
+    }
+
+    // The tail joins the last piece unless it is worth one of its own
+    if (split->count > 0 && p - last_cut < min_chunk) {
+        split->bounds[split->count] = split->end;
+    } else {
+        split_push(split, &capacity, split->end);
+    }
+    return true;
+}
+
+void split_free(DeclarationSplit* split) {
+    free(split->bounds);
+    split->bounds = NULL;
+    split->count = 0;
+}
+
+// ============================================================================
+// WORKER POOL
+// ============================================================================
+
+typedef struct {
+    ParallelTask task;
+    void* context;
+    int task_count;
+    int next_task;      // Claimed with an atomic increment
+} WorkQueue;
+
+typedef struct {
+    WorkQueue* queue;
+    int worker;
+} Worker;
+
+static void work_drain(WorkQueue* queue, int worker) {
+    int task;
+    while ((task = __atomic_fetch_add(&queue->next_task, 1, __ATOMIC_RELAXED)) < queue->task_count) {
+        queue->task(queue->context, worker, task);
+    }
+}
+
+static void* worker_main(void* argument) {
+    Worker* worker = argument;
+    work_drain(worker->queue, worker->worker);
+    return NULL;
+}
+
+// Runs task(context, worker, i) for every i in [0, task_count) on up to
+// `jobs` threads, the caller being worker 0. Tasks are claimed in order, so
+// one slow piece does not hold the others up. The symbol table is shared
+// for the duration
+void parallel_for(int task_count, int jobs, ParallelTask task, void* context) {
+    if (jobs > task_count) jobs = task_count;
+    if (jobs > PARALLEL_MAX_JOBS) jobs = PARALLEL_MAX_JOBS;
+
+    WorkQueue queue = {task, context, task_count, 0};
+    pthread_t threads[PARALLEL_MAX_JOBS];
+    Worker workers[PARALLEL_MAX_JOBS];
+    int started = 0;
+
+    // Scanners pick their implementation on first use; do it before racing
+    scan_implementation();
+    symbol_table_set_shared(true);
+
+    for (int i = 1; i < jobs; i++) {
+        workers[i] = (Worker){&queue, i};
+        if (pthread_create(&threads[started], NULL, worker_main, &workers[i]) != 0) break;
+        started++;
+    }
+
+    work_drain(&queue, 0);
+
+    for (int i = 0; i < started; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    symbol_table_set_shared(false);
+}
+
+int parallel_default_jobs(void) {
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    if (cpus < 1) return 1;
+    return cpus > PARALLEL_MAX_JOBS ? PARALLEL_MAX_JOBS : (int)cpus;
+}
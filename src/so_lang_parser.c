@@ -0,0 +1,630 @@
+/*
+ * so_lang_parser.c - So Lang Core Parser
+ * Precedence-climbing expressions, statements with panic-mode recovery and
+ * parallel top-level parsing; every frontend builds its AST through these
+ */
+
+#include "so_lang.h"
+#include "so_lang_parser.h"
+#include "so_lang_operators.h"
+
+// Functions declared by the files parsed so far
+static Symbol* function_names = NULL;
+static int function_count = 0;
+
+// ============================================================================
+// AST CONSTRUCTION
+// ============================================================================
+
+// Arena memory is zeroed, so every link starts NULL and every flag false
+ASTNode* ast_create_node(Arena* arena, NodeType type) {
+    ASTNode* node = arena_alloc(arena, sizeof(ASTNode));
+    node->type = type;
+    return node;
+}
+
+// The first AST_LIST_INLINE child slots are allocated right behind the node
+ASTNode* ast_create_list_node(Arena* arena, NodeType type) {
+    ASTNode* node = arena_alloc(arena, sizeof(ASTNode) + sizeof(ASTNode*) * AST_LIST_INLINE);
+    node->type = type;
+    node->as.list.items = (ASTNode**)(node + 1);
+    return node;
+}
+
+void ast_list_append(Arena* arena, ASTNode* list, ASTNode* child) {
+    list->as.list.items = arena_list_grow(arena, list->as.list.items, list->as.list.count, sizeof(ASTNode*));
+    list->as.list.items[list->as.list.count++] = child;
+}
+
+// ============================================================================
+// PARSER
+// ============================================================================
+
+Parser* parser_create(Lexer* lexer, Arena* arena) {
+    Parser* parser = malloc(sizeof(Parser));
+    parser->source = lexer->source;
+    parser->lexer = lexer;
+    parser->arena = arena;
+    parser->panicking = false;
+    parser->previous_end = 0;
+    parser->jobs = 1;
+    return parser;
+}
+
+Token* parser_current_token(Parser* parser) {
+    return lexer_peek(parser->lexer, 0);
+}
+
+Token* parser_advance(Parser* parser) {
+    Token* token = lexer_next_token(parser->lexer);
+    // Statements swallow the newlines after them; spans stop before those.
+    // A string's slice leaves out its quotes, so its end is one further
+    if (token->type != TOKEN_NEWLINE) {
+        parser->previous_end = token->start + token->length + (token->type == TOKEN_STRING);
+    }
+    return token;
+}
+
+bool parser_match(Parser* parser, TokenType type) {
+    if (parser_current_token(parser)->type == type) {
+        parser_advance(parser);
+        return true;
+    }
+    return false;
+}
+
+// A node covers everything from `start` through the last token consumed
+void parser_span(Parser* parser, ASTNode* node, int start) {
+    node->span.start = start;
+    node->span.length = parser->previous_end > start ? parser->previous_end - start : 0;
+}
+
+// Errors after the first one in a statement are usually fallout from it,
+// so nothing more is reported until the parser has resynchronized
+void parser_error(Parser* parser, DiagnosticCode code, const Token* token, const char* message) {
+    if (!parser->panicking) {
+        diag_report(code, token->start, token->length, message);
+    }
+    parser->panicking = true;
+}
+
+bool parser_expect(Parser* parser, TokenType type, const char* message) {
+    if (parser_match(parser, type)) return true;
+    parser_error(parser, DIAG_EXPECTED_TOKEN, parser_current_token(parser), message);
+    return false;
+}
+
+// Panic mode: skip the rest of a broken statement. Stops after a newline or
+// ';', or before a '}' (so the enclosing block still closes) or a keyword
+// that starts the next statement
+static void parser_synchronize(Parser* parser) {
+    parser->panicking = false;
+
+    for (;;) {
+        switch (parser_current_token(parser)->type) {
+            case TOKEN_NEWLINE:
+            case TOKEN_SEMICOLON:
+                parser_advance(parser);
+                return;
+            case TOKEN_EOF:
+            case TOKEN_RBRACE:
+            case TOKEN_FN:
+            case TOKEN_LET:
+            case TOKEN_IF:
+            case TOKEN_RETURN:
+            case TOKEN_PRINT:
+                return;
+            default:
+                parser_advance(parser);
+                break;
+        }
+    }
+}
+
+// Runs after every statement: resynchronizes if it failed, and makes sure a
+// statement that consumed nothing is not parsed again forever
+void parser_recover(Parser* parser, int start) {
+    bool failed = parser->panicking;
+    if (failed) parser_synchronize(parser);
+
+    if (parser->lexer->ring_head == start) {
+        if (!failed) {
+            parser_error(parser, DIAG_UNEXPECTED_TOKEN, parser_current_token(parser), "Unexpected token");
+        }
+        parser->panicking = false;
+        parser_advance(parser);
+    }
+}
+
+static ASTNode* parser_parse_precedence(Parser* parser, int min_precedence);
+static ASTNode* parser_parse_block(Parser* parser);
+
+// name(argument, ...); the arguments are the node's child list
+static ASTNode* parser_parse_call(Parser* parser) {
+    ASTNode* call = ast_create_list_node(parser->arena, NODE_FUNC_CALL);
+    call->value = token_symbol(parser->source, parser_advance(parser));
+    parser_advance(parser); // Skip '('
+
+    if (parser_current_token(parser)->type != TOKEN_RPAREN) {
+        do {
+            ASTNode* argument = parser_parse_expression(parser);
+            if (!argument) break;
+            ast_list_append(parser->arena, call, argument);
+        } while (parser_match(parser, TOKEN_COMMA));
+    }
+
+    parser_expect(parser, TOKEN_RPAREN, "Expected ')' after arguments");
+    return call;
+}
+
+static ASTNode* parser_parse_primary(Parser* parser) {
+    Token* token = parser_current_token(parser);
+    int start = token->start;
+    ASTNode* node = NULL;
+
+    if (token->type == TOKEN_NUMBER) {
+        node = ast_create_node(parser->arena, NODE_NUMBER);
+        node->value = token_symbol(parser->source, token);
+        parser_advance(parser);
+        parser_span(parser, node, start);
+    } else if (token->type == TOKEN_STRING) {
+        node = ast_create_node(parser->arena, NODE_STRING);
+        node->value = token_symbol(parser->source, token);
+        parser_advance(parser);
+        parser_span(parser, node, start - 1); // Opening quote
+    } else if (token->type == TOKEN_IDENTIFIER) {
+        // A '(' right after the name makes it a call
+        if (lexer_peek(parser->lexer, 1)->type == TOKEN_LPAREN) {
+            node = parser_parse_call(parser);
+        } else {
+            node = ast_create_node(parser->arena, NODE_IDENTIFIER);
+            node->value = token_symbol(parser->source, token);
+            parser_advance(parser);
+        }
+        parser_span(parser, node, start);
+    } else if (token->type == TOKEN_LPAREN) {
+        parser_advance(parser);
+        node = parser_parse_expression(parser);
+        parser_expect(parser, TOKEN_RPAREN, "Expected ')'");
+    } else {
+        parser_error(parser, DIAG_EXPECTED_EXPRESSION, token, "Expected expression");
+    }
+
+    return node;
+}
+
+// Prefix operators bind tighter than any infix one except member access
+static ASTNode* parser_parse_unary(Parser* parser) {
+    Token* op = parser_current_token(parser);
+
+    if (op->type == TOKEN_NOT || op->type == TOKEN_MINUS) {
+        int start = op->start;
+        ASTNode* unary = ast_create_node(parser->arena, NODE_UNARY_OP);
+        unary->op = op->type;
+        unary->value = token_symbol(parser->source, op);
+        parser_advance(parser);
+        
+        unary->as.operand = parser_parse_precedence(parser, PREC_UNARY);
+        parser_span(parser, unary, start);
+        return unary;
+    }
+
+    return parser_parse_primary(parser);
+}
+
+// Precedence climbing: folds infix operators left to right while they bind
+// tighter than min_precedence, recursing only for a tighter right operand,
+// so left-associative chains build without extra depth
+static ASTNode* parser_parse_precedence(Parser* parser, int min_precedence) {
+    Token* first = parser_current_token(parser);
+    int start = first->start - (first->type == TOKEN_STRING); // Opening quote
+    ASTNode* left = parser_parse_unary(parser);
+
+    for (;;) {
+        Token* op = parser_current_token(parser);
+        const OperatorInfo* info = &infix_operators[op->type];
+        if (info->precedence <= min_precedence) break;
+        
+        if (op->type == TOKEN_DOT) {
+            parser_advance(parser);
+            Token* member = parser_current_token(parser);
+            if (member->type != TOKEN_IDENTIFIER) {
+                parser_error(parser, DIAG_EXPECTED_TOKEN, member, "Expected member name after '.'");
+                break;
+            }
+            
+            ASTNode* access = ast_create_node(parser->arena, NODE_MEMBER_ACCESS);
+            access->value = token_symbol(parser->source, member);
+            access->as.operand = left;
+            parser_advance(parser);
+            parser_span(parser, access, start);
+            left = access;
+            continue;
+        }
+        
+        // Copy the operator out before the ring moves on
+        ASTNode* binary = ast_create_node(parser->arena, NODE_BINARY_OP);
+        binary->op = op->type;
+        binary->value = token_symbol(parser->source, op);
+        parser_advance(parser);
+        
+        binary->as.binary.left = left;
+        binary->as.binary.right = parser_parse_precedence(parser,
+            info->right_assoc ? info->precedence - 1 : info->precedence);
+        parser_span(parser, binary, start);
+        left = binary;
+    }
+
+    return left;
+}
+
+ASTNode* parser_parse_expression(Parser* parser) {
+    return parser_parse_precedence(parser, PREC_NONE);
+}
+
+static ASTNode* parser_parse_block(Parser* parser) {
+    ASTNode* block = ast_create_list_node(parser->arena, NODE_PROGRAM);
+    int block_start = parser_current_token(parser)->start;
+
+    if (!parser_expect(parser, TOKEN_LBRACE, "Expected '{'")) {
+        parser_span(parser, block, block_start);
+        return block;
+    }
+
+    // A '{' is a synchronization point: the block parses normally even when
+    // the statement that opened it already failed
+    parser->panicking = false;
+
+    while (!diag_limit_reached() &&
+           parser_current_token(parser)->type != TOKEN_RBRACE && 
+           parser_current_token(parser)->type != TOKEN_EOF) {
+        
+        // Skip newlines
+        if (parser_match(parser, TOKEN_NEWLINE)) {
+            continue;
+        }
+        
+        int start = parser->lexer->ring_head;
+        ASTNode* stmt = parser_parse_statement(parser);
+        if (stmt) {
+            ast_list_append(parser->arena, block, stmt);
+        }
+        parser_recover(parser, start);
+    }
+
+    parser_expect(parser, TOKEN_RBRACE, "Expected '}' to close the block");
+    parser_span(parser, block, block_start);
+    return block;
+}
+
+// `(name, name: type, ...)`; the parentheses may be left out when there are
+// no parameters
+static ASTNode* parser_parse_parameters(Parser* parser) {
+    ASTNode* params = ast_create_list_node(parser->arena, NODE_PROGRAM);
+    int list_start = parser_current_token(parser)->start;
+
+    if (!parser_match(parser, TOKEN_LPAREN)) {
+        return params;
+    }
+
+    while (parser_current_token(parser)->type != TOKEN_RPAREN &&
+           parser_current_token(parser)->type != TOKEN_LBRACE &&
+           parser_current_token(parser)->type != TOKEN_EOF) {
+        Token* name = parser_current_token(parser);
+        if (name->type != TOKEN_IDENTIFIER) {
+            parser_error(parser, DIAG_EXPECTED_TOKEN, name, "Expected parameter name");
+            break;
+        }
+        
+        int start = name->start;
+        ASTNode* param = ast_create_node(parser->arena, NODE_PARAM);
+        param->value = token_symbol(parser->source, name);
+        parser_advance(parser);
+        
+        if (parser_match(parser, TOKEN_COLON)) {
+            Token* type = parser_current_token(parser);
+            if (type->type != TOKEN_IDENTIFIER) {
+                parser_error(parser, DIAG_EXPECTED_TOKEN, type, "Expected parameter type after ':'");
+                break;
+            }
+            param->as.type_name = token_symbol(parser->source, type);
+            parser_advance(parser);
+        }
+        
+        parser_span(parser, param, start);
+        ast_list_append(parser->arena, params, param);
+        if (!parser_match(parser, TOKEN_COMMA)) break;
+    }
+
+    // A broken list is skipped up to the body rather than swallowing it
+    if (parser_current_token(parser)->type != TOKEN_RPAREN) {
+        parser_error(parser, DIAG_EXPECTED_TOKEN, parser_current_token(parser), "Expected ')' after parameters");
+        while (parser_current_token(parser)->type != TOKEN_RPAREN &&
+               parser_current_token(parser)->type != TOKEN_LBRACE &&
+               parser_current_token(parser)->type != TOKEN_EOF) {
+            parser_advance(parser);
+        }
+    }
+    parser_match(parser, TOKEN_RPAREN);
+    parser_span(parser, params, list_start);
+    return params;
+}
+
+static ASTNode* parser_parse_function(Parser* parser) {
+    int start = parser_advance(parser)->start; // consume 'fn'
+
+    ASTNode* func = ast_create_node(parser->arena, NODE_FUNC_DECL);
+
+    // Get function name
+    Token* name = parser_current_token(parser);
+    if (name->type == TOKEN_IDENTIFIER) {
+        func->value = token_symbol(parser->source, name);
+        parser_advance(parser);
+        
+        func->as.function.params = parser_parse_parameters(parser);
+        func->as.function.body = parser_parse_block(parser);
+    } else {
+        parser_error(parser, DIAG_EXPECTED_TOKEN, name, "Expected function name after 'fn'");
+    }
+
+    parser_span(parser, func, start);
+    return func;
+}
+
+ASTNode* parser_parse_statement(Parser* parser) {
+    Token* token = parser_current_token(parser);
+    int start = token->start;
+    ASTNode* node = NULL;
+
+    if (token->type == TOKEN_FN) {
+        node = parser_parse_function(parser);
+    } else if (token->type == TOKEN_LET) {
+        parser_advance(parser);
+        node = ast_create_node(parser->arena, NODE_VAR_DECL);
+        
+        Token* name = parser_current_token(parser);
+        if (name->type == TOKEN_IDENTIFIER) {
+            node->value = token_symbol(parser->source, name);
+            parser_advance(parser);
+            
+            if (parser_match(parser, TOKEN_ASSIGN)) {
+                node->as.operand = parser_parse_expression(parser);
+            }
+        } else {
+            parser_error(parser, DIAG_EXPECTED_TOKEN, name, "Expected variable name after 'let'");
+        }
+        parser_span(parser, node, start);
+    } else if (token->type == TOKEN_PRINT) {
+        parser_advance(parser);
+        node = ast_create_node(parser->arena, NODE_PRINT_STMT);
+        
+        if (parser_expect(parser, TOKEN_LPAREN, "Expected '(' after 'print'")) {
+            node->as.operand = parser_parse_expression(parser);
+            parser_expect(parser, TOKEN_RPAREN, "Expected ')'");
+        }
+        parser_span(parser, node, start);
+    } else if (token->type == TOKEN_IF) {
+        parser_advance(parser);
+        node = ast_create_list_node(parser->arena, NODE_IF_STMT);
+        
+        // Condition, then and else all fit in the inline slots
+        ASTNode** branch = node->as.list.items;
+        node->as.list.count = 2;
+        
+        branch[IF_CONDITION] = parser_parse_expression(parser);
+        branch[IF_THEN] = parser_parse_block(parser);
+        
+        if (parser_match(parser, TOKEN_ELSE)) {
+            if (parser_current_token(parser)->type == TOKEN_IF) {
+                // else if
+                branch[IF_ELSE] = parser_parse_statement(parser);
+            } else {
+                // else
+                branch[IF_ELSE] = parser_parse_block(parser);
+            }
+            node->as.list.count = 3;
+        }
+        parser_span(parser, node, start);
+    } else if (token->type == TOKEN_RETURN) {
+        parser_advance(parser);
+        node = ast_create_node(parser->arena, NODE_RETURN_STMT);
+        
+        if (parser_current_token(parser)->type != TOKEN_NEWLINE &&
+            parser_current_token(parser)->type != TOKEN_SEMICOLON &&
+            parser_current_token(parser)->type != TOKEN_RBRACE &&
+            parser_current_token(parser)->type != TOKEN_EOF) {
+            node->as.operand = parser_parse_expression(parser);
+        }
+        parser_span(parser, node, start);
+    } else {
+        // Expression statement
+        node = parser_parse_expression(parser);
+    }
+
+    // Skip newlines and semicolons
+    while (parser_match(parser, TOKEN_NEWLINE) || parser_match(parser, TOKEN_SEMICOLON)) {
+        // Skip
+    }
+
+    return node;
+}
+
+// Statements up to the end of the lexer's range, as one NODE_PROGRAM list
+static ASTNode* parser_parse_statements(Parser* parser) {
+    ASTNode* program = ast_create_list_node(parser->arena, NODE_PROGRAM);
+    int program_start = parser_current_token(parser)->start;
+
+    // Keep going past errors so one run reports all of them, up to the limit
+    while (!diag_limit_reached() && parser_current_token(parser)->type != TOKEN_EOF) {
+        // Skip newlines at top level
+        if (parser_match(parser, TOKEN_NEWLINE)) {
+            continue;
+        }
+        
+        int start = parser->lexer->ring_head;
+        ASTNode* stmt = parser_parse_statement(parser);
+        if (stmt) {
+            ast_list_append(parser->arena, program, stmt);
+        }
+        parser_recover(parser, start);
+    }
+
+    parser_span(parser, program, program_start);
+    return program;
+}
+
+// ============================================================================
+// PARALLEL TOP-LEVEL PARSING
+// ============================================================================
+
+typedef struct {
+    char* source;
+    LexerDialect dialect;
+    const int* bounds;
+    ASTNode** pieces;       // Statements of each piece
+    int* token_counts;
+    Arena* arenas;          // One per worker
+} ParallelParse;
+
+static void parser_parse_piece(void* context, int worker, int task) {
+    ParallelParse* job = context;
+    Lexer* lexer = lexer_create_range(job->source, job->bounds[task], job->bounds[task + 1], job->dialect);
+    Parser* parser = parser_create(lexer, &job->arenas[worker]);
+
+    job->pieces[task] = parser_parse_statements(parser);
+    job->token_counts[task] = lexer->token_count;
+
+    parser_free(parser);
+    lexer_free(lexer);
+}
+
+// Top-level declarations do not depend on each other, so a large input is
+// cut between them and the pieces are parsed on parser->jobs threads, each
+// into its own arena. The pieces' statements are joined in source order and
+// the arenas handed to the parser's. Any diagnostic throws the result away
+// (NULL) so the sequential parser reports errors exactly as it always has
+static ASTNode* parser_parse_parallel(Parser* parser) {
+    Lexer* lexer = parser->lexer;
+    int start = (int)(lexer->cur - lexer->source);
+    int end = (int)(lexer->end - lexer->source);
+
+    if (lexer->token_count != 0 || end - start < 2 * PARALLEL_MIN_CHUNK) return NULL;
+
+    int min_chunk = (end - start) / (parser->jobs * 4);
+    if (min_chunk < PARALLEL_MIN_CHUNK) min_chunk = PARALLEL_MIN_CHUNK;
+
+    DeclarationSplit split;
+    if (!split_declarations(lexer->source, start, end, min_chunk, &split)) return NULL;
+    if (split.count < 2 || split.end != end) {
+        split_free(&split);
+        return NULL;
+    }
+
+    ParallelParse job = {
+        .source = lexer->source,
+        .dialect = lexer->dialect,
+        .bounds = split.bounds,
+        .pieces = calloc(split.count, sizeof(ASTNode*)),
+        .token_counts = calloc(split.count, sizeof(int)),
+        .arenas = calloc(parser->jobs, sizeof(Arena)),
+    };
+    for (int i = 0; i < parser->jobs; i++) {
+        arena_init(&job.arenas[i]);
+    }
+
+    parallel_for(split.count, parser->jobs, parser_parse_piece, &job);
+
+    ASTNode* program = NULL;
+    if (diag_error_count() == 0) {
+        program = ast_create_list_node(parser->arena, NODE_PROGRAM);
+        int program_end = 0;
+        int tokens = 1; // One EOF for the whole input, as a single lexer counts
+        
+        for (int i = 0; i < split.count; i++) {
+            ASTNode* piece = job.pieces[i];
+            for (int j = 0; j < piece->as.list.count; j++) {
+                ast_list_append(parser->arena, program, piece->as.list.items[j]);
+            }
+            if (piece->span.length > 0) program_end = piece->span.start + piece->span.length;
+            tokens += job.token_counts[i] - 1;
+        }
+        
+        program->span.start = job.pieces[0]->span.start;
+        program->span.length = program_end > program->span.start ? program_end - program->span.start : 0;
+        
+        // The caller's lexer ends up where it would after a sequential parse:
+        // everything counted, sitting on the EOF
+        lexer->token_count = tokens - 1;
+        lexer_seek(lexer, end);
+        parser_current_token(parser);
+        parser->previous_end = program_end;
+        
+        for (int i = 0; i < parser->jobs; i++) {
+            arena_adopt(parser->arena, &job.arenas[i]);
+        }
+    } else {
+        diag_reset();
+        for (int i = 0; i < parser->jobs; i++) {
+            arena_free(&job.arenas[i]);
+        }
+    }
+
+    free(job.pieces);
+    free(job.token_counts);
+    free(job.arenas);
+    split_free(&split);
+    return program;
+}
+
+// Function registry, rebuilt from the finished tree so it does not depend
+// on which thread parsed what. Functions only live in statement lists
+static VisitAction parser_register_function(AstWalk* walk, ASTNode* node) {
+    (void)walk;
+
+    switch (node->type) {
+        case NODE_PROGRAM:
+        case NODE_IF_STMT:
+            return VISIT_CONTINUE;
+        case NODE_FUNC_DECL:
+            if (node->value == SYMBOL_NONE) return VISIT_SKIP;
+            if (!function_names) {
+                function_names = malloc(sizeof(Symbol) * MAX_FUNCTIONS);
+            }
+            if (function_count < MAX_FUNCTIONS) {
+                function_names[function_count++] = node->value;
+            }
+            return VISIT_CONTINUE;
+        default:
+            return VISIT_SKIP;
+    }
+}
+
+static const AstVisitor function_registry = {parser_register_function, NULL, NULL, NULL};
+
+ASTNode* parser_parse(Parser* parser) {
+    ASTNode* program = NULL;
+    if (parser->jobs > 1) {
+        program = parser_parse_parallel(parser);
+    }
+    if (!program) {
+        program = parser_parse_statements(parser);
+    }
+
+    ast_walk(program, &function_registry, NULL);
+    return program;
+}
+
+void parser_free(Parser* parser) {
+    free(parser);
+}
+
+int parser_function_count(void) {
+    return function_count;
+}
+
+// Forgets every registered function, so the next file starts from none
+void parser_functions_free(void) {
+    free(function_names);
+    function_names = NULL;
+    function_count = 0;
+}
@@ -0,0 +1,27 @@
+/*
+ * so_lang_parser.h - So Lang Shared Parser Interface
+ * The core parser's token helpers and statement entry points, defined in
+ * so_lang_parser.c; the other frontends parse on top of them
+ */
+
+#ifndef SO_LANG_PARSER_H
+#define SO_LANG_PARSER_H
+
+#include "so_lang.h"
+
+Token* parser_current_token(Parser* parser);
+Token* parser_advance(Parser* parser);
+bool parser_match(Parser* parser, TokenType type);
+void parser_error(Parser* parser, DiagnosticCode code, const Token* token, const char* message);
+bool parser_expect(Parser* parser, TokenType type, const char* message);
+void parser_span(Parser* parser, ASTNode* node, int start);
+void parser_recover(Parser* parser, int start);
+
+ASTNode* parser_parse_expression(Parser* parser);
+ASTNode* parser_parse_statement(Parser* parser);
+
+// Functions registered by parser_parse since the last parser_functions_free
+int parser_function_count(void);
+void parser_functions_free(void);
+
+#endif // SO_LANG_PARSER_H
@@ -0,0 +1,328 @@
+/*
+ * so_lang_scan.c - So Lang Character Classification and Run Scanners
+ * Finds run boundaries 16 (SSE2) or 32 (AVX2) bytes at a time, with a
+ * scalar fallback for short tails and non-x86 hosts
+ */
+
+#include <stddef.h>
+#include <string.h>
+
+#include "so_lang_scan.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define SCAN_X86 1
+#endif
+
+// ============================================================================
+// CHARACTER CLASSES
+// ============================================================================
+
+#define S CHAR_SPACE
+#define A CHAR_ALPHA
+#define D CHAR_DIGIT
+
+const unsigned char char_class[256] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 0, S, 0, S, S, S, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    S, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    D, D, D, D, D, D, D, D, D, D, 0, 0, 0, 0, 0, 0,
+    0, A, A, A, A, A, A, A, A, A, A, A, A, A, A, A,
+    A, A, A, A, A, A, A, A, A, A, A, 0, 0, 0, 0, A,
+    0, A, A, A, A, A, A, A, A, A, A, A, A, A, A, A,
+    A, A, A, A, A, A, A, A, A, A, A, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+};
+
+#undef S
+#undef A
+#undef D
+
+// ============================================================================
+// SCALAR SCANNERS
+// ============================================================================
+
+static const char* scan_whitespace_scalar(const char* p, const char* end) {
+    while (p < end && is_space_char(*p)) p++;
+    return p;
+}
+
+static const char* scan_identifier_scalar(const char* p, const char* end) {
+    while (p < end && is_ident_char(*p)) p++;
+    return p;
+}
+
+static const char* scan_string_scalar(const char* p, const char* end) {
+    while (p < end && *p != '"' && *p != '\\') p++;
+    return p;
+}
+
+static const char* scan_structure_scalar(const char* p, const char* end) {
+    while (p < end && *p != '{' && *p != '}' && *p != '"' && *p != '/') p++;
+    return p;
+}
+
+#ifdef SCAN_X86
+
+// ============================================================================
+// SSE2 SCANNERS (16 BYTES PER STEP)
+// ============================================================================
+
+__attribute__((target("sse2")))
+static inline __m128i sse2_in_range(__m128i v, char lo, char hi) {
+    return _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8((char)(lo - 1))),
+                         _mm_cmplt_epi8(v, _mm_set1_epi8((char)(hi + 1))));
+}
+
+__attribute__((target("sse2")))
+static inline unsigned sse2_space_mask(__m128i v) {
+    __m128i space = _mm_cmpeq_epi8(v, _mm_set1_epi8(' '));
+    __m128i control = sse2_in_range(v, '\t', '\r');
+    __m128i newline = _mm_cmpeq_epi8(v, _mm_set1_epi8('\n'));
+    return (unsigned)_mm_movemask_epi8(
+        _mm_or_si128(space, _mm_andnot_si128(newline, control)));
+}
+
+__attribute__((target("sse2")))
+static inline unsigned sse2_ident_mask(__m128i v) {
+    __m128i lower = _mm_or_si128(v, _mm_set1_epi8(0x20));
+    __m128i ident = _mm_or_si128(sse2_in_range(lower, 'a', 'z'),
+                                 sse2_in_range(v, '0', '9'));
+    ident = _mm_or_si128(ident, _mm_cmpeq_epi8(v, _mm_set1_epi8('_')));
+    return (unsigned)_mm_movemask_epi8(ident);
+}
+
+__attribute__((target("sse2")))
+static const char* scan_whitespace_sse2(const char* p, const char* end) {
+    while (end - p >= 16) {
+        unsigned stop = ~sse2_space_mask(_mm_loadu_si128((const __m128i*)p)) & 0xFFFFu;
+        if (stop) return p + __builtin_ctz(stop);
+        p += 16;
+    }
+    return scan_whitespace_scalar(p, end);
+}
+
+__attribute__((target("sse2")))
+static const char* scan_identifier_sse2(const char* p, const char* end) {
+    while (end - p >= 16) {
+        unsigned stop = ~sse2_ident_mask(_mm_loadu_si128((const __m128i*)p)) & 0xFFFFu;
+        if (stop) return p + __builtin_ctz(stop);
+        p += 16;
+    }
+    return scan_identifier_scalar(p, end);
+}
+
+__attribute__((target("sse2")))
+static const char* scan_string_sse2(const char* p, const char* end) {
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+
+    while (end - p >= 16) {
+        __m128i v = _mm_loadu_si128((const __m128i*)p);
+        unsigned stop = (unsigned)_mm_movemask_epi8(
+            _mm_or_si128(_mm_cmpeq_epi8(v, quote), _mm_cmpeq_epi8(v, backslash)));
+        if (stop) return p + __builtin_ctz(stop);
+        p += 16;
+    }
+    return scan_string_scalar(p, end);
+}
+
+__attribute__((target("sse2")))
+static const char* scan_structure_sse2(const char* p, const char* end) {
+    const __m128i open = _mm_set1_epi8('{');
+    const __m128i close = _mm_set1_epi8('}');
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i slash = _mm_set1_epi8('/');
+
+    while (end - p >= 16) {
+        __m128i v = _mm_loadu_si128((const __m128i*)p);
+        __m128i brace = _mm_or_si128(_mm_cmpeq_epi8(v, open), _mm_cmpeq_epi8(v, close));
+        __m128i other = _mm_or_si128(_mm_cmpeq_epi8(v, quote), _mm_cmpeq_epi8(v, slash));
+        unsigned stop = (unsigned)_mm_movemask_epi8(_mm_or_si128(brace, other));
+        if (stop) return p + __builtin_ctz(stop);
+        p += 16;
+    }
+    return scan_structure_scalar(p, end);
+}
+
+// ============================================================================
+// AVX2 SCANNERS (32 BYTES PER STEP)
+// ============================================================================
+
+__attribute__((target("avx2")))
+static inline __m256i avx2_in_range(__m256i v, char lo, char hi) {
+    return _mm256_and_si256(_mm256_cmpgt_epi8(v, _mm256_set1_epi8((char)(lo - 1))),
+                            _mm256_cmpgt_epi8(_mm256_set1_epi8((char)(hi + 1)), v));
+}
+
+__attribute__((target("avx2")))
+static inline unsigned avx2_space_mask(__m256i v) {
+    __m256i space = _mm256_cmpeq_epi8(v, _mm256_set1_epi8(' '));
+    __m256i control = avx2_in_range(v, '\t', '\r');
+    __m256i newline = _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\n'));
+    return (unsigned)_mm256_movemask_epi8(
+        _mm256_or_si256(space, _mm256_andnot_si256(newline, control)));
+}
+
+__attribute__((target("avx2")))
+static inline unsigned avx2_ident_mask(__m256i v) {
+    __m256i lower = _mm256_or_si256(v, _mm256_set1_epi8(0x20));
+    __m256i ident = _mm256_or_si256(avx2_in_range(lower, 'a', 'z'),
+                                    avx2_in_range(v, '0', '9'));
+    ident = _mm256_or_si256(ident, _mm256_cmpeq_epi8(v, _mm256_set1_epi8('_')));
+    return (unsigned)_mm256_movemask_epi8(ident);
+}
+
+__attribute__((target("avx2")))
+static const char* scan_whitespace_avx2(const char* p, const char* end) {
+    while (end - p >= 32) {
+        unsigned stop = ~avx2_space_mask(_mm256_loadu_si256((const __m256i*)p));
+        if (stop) return p + __builtin_ctz(stop);
+        p += 32;
+    }
+    return scan_whitespace_sse2(p, end);
+}
+
+__attribute__((target("avx2")))
+static const char* scan_identifier_avx2(const char* p, const char* end) {
+    while (end - p >= 32) {
+        unsigned stop = ~avx2_ident_mask(_mm256_loadu_si256((const __m256i*)p));
+        if (stop) return p + __builtin_ctz(stop);
+        p += 32;
+    }
+    return scan_identifier_sse2(p, end);
+}
+
+__attribute__((target("avx2")))
+static const char* scan_string_avx2(const char* p, const char* end) {
+    const __m256i quote = _mm256_set1_epi8('"');
+    const __m256i backslash = _mm256_set1_epi8('\\');
+
+    while (end - p >= 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i*)p);
+        unsigned stop = (unsigned)_mm256_movemask_epi8(
+            _mm256_or_si256(_mm256_cmpeq_epi8(v, quote), _mm256_cmpeq_epi8(v, backslash)));
+        if (stop) return p + __builtin_ctz(stop);
+        p += 32;
+    }
+    return scan_string_sse2(p, end);
+}
+
+__attribute__((target("avx2")))
+static const char* scan_structure_avx2(const char* p, const char* end) {
+    const __m256i open = _mm256_set1_epi8('{');
+    const __m256i close = _mm256_set1_epi8('}');
+    const __m256i quote = _mm256_set1_epi8('"');
+    const __m256i slash = _mm256_set1_epi8('/');
+
+    while (end - p >= 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i*)p);
+        __m256i brace = _mm256_or_si256(_mm256_cmpeq_epi8(v, open), _mm256_cmpeq_epi8(v, close));
+        __m256i other = _mm256_or_si256(_mm256_cmpeq_epi8(v, quote), _mm256_cmpeq_epi8(v, slash));
+        unsigned stop = (unsigned)_mm256_movemask_epi8(_mm256_or_si256(brace, other));
+        if (stop) return p + __builtin_ctz(stop);
+        p += 32;
+    }
+    return scan_structure_sse2(p, end);
+}
+
+#endif // SCAN_X86
+
+// ============================================================================
+// RUNTIME DISPATCH
+// ============================================================================
+
+static const char* scan_whitespace_resolve(const char* p, const char* end);
+static const char* scan_identifier_resolve(const char* p, const char* end);
+static const char* scan_string_resolve(const char* p, const char* end);
+static const char* scan_structure_resolve(const char* p, const char* end);
+
+const char* (*scan_whitespace)(const char*, const char*) = scan_whitespace_resolve;
+const char* (*scan_identifier)(const char*, const char*) = scan_identifier_resolve;
+const char* (*scan_string)(const char*, const char*) = scan_string_resolve;
+const char* (*scan_structure)(const char*, const char*) = scan_structure_resolve;
+
+static const char* scan_name = NULL;
+
+static void scan_select(void) {
+#ifdef SCAN_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        scan_whitespace = scan_whitespace_avx2;
+        scan_identifier = scan_identifier_avx2;
+        scan_string = scan_string_avx2;
+        scan_structure = scan_structure_avx2;
+        scan_name = "avx2";
+        return;
+    }
+    if (__builtin_cpu_supports("sse2")) {
+        scan_whitespace = scan_whitespace_sse2;
+        scan_identifier = scan_identifier_sse2;
+        scan_string = scan_string_sse2;
+        scan_structure = scan_structure_sse2;
+        scan_name = "sse2";
+        return;
+    }
+#endif
+    scan_whitespace = scan_whitespace_scalar;
+    scan_identifier = scan_identifier_scalar;
+    scan_string = scan_string_scalar;
+    scan_structure = scan_structure_scalar;
+    scan_name = "scalar";
+}
+
+static const char* scan_whitespace_resolve(const char* p, const char* end) {
+    scan_select();
+    return scan_whitespace(p, end);
+}
+
+static const char* scan_identifier_resolve(const char* p, const char* end) {
+    scan_select();
+    return scan_identifier(p, end);
+}
+
+static const char* scan_string_resolve(const char* p, const char* end) {
+    scan_select();
+    return scan_string(p, end);
+}
+
+static const char* scan_structure_resolve(const char* p, const char* end) {
+    scan_select();
+    return scan_structure(p, end);
+}
+
+const char* scan_implementation(void) {
+    if (!scan_name) scan_select();
+    return scan_name;
+}
+
+bool scan_force_implementation(const char* name) {
+    scan_select();
+    if (strcmp(name, scan_name) == 0) return true;
+#ifdef SCAN_X86
+    if (strcmp(name, "sse2") == 0 && __builtin_cpu_supports("sse2")) {
+        scan_whitespace = scan_whitespace_sse2;
+        scan_identifier = scan_identifier_sse2;
+        scan_string = scan_string_sse2;
+        scan_structure = scan_structure_sse2;
+        scan_name = "sse2";
+        return true;
+    }
+#endif
+    if (strcmp(name, "scalar") == 0) {
+        scan_whitespace = scan_whitespace_scalar;
+        scan_identifier = scan_identifier_scalar;
+        scan_string = scan_string_scalar;
+        scan_structure = scan_structure_scalar;
+        scan_name = "scalar";
+        return true;
+    }
+    return false;
+}
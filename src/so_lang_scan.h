@@ -0,0 +1,44 @@
+/*
+ * so_lang_scan.h - So Lang Character Classification and Run Scanners
+ * Locale-independent byte classes plus SIMD scans for the lexer hot paths
+ */
+
+#ifndef SO_LANG_SCAN_H
+#define SO_LANG_SCAN_H
+
+#include <stdbool.h>
+
+#define CHAR_SPACE  0x01    // ' ', '\t', '\r', '\v', '\f' (not '\n')
+#define CHAR_ALPHA  0x02    // A-Z, a-z, '_'
+#define CHAR_DIGIT  0x04    // 0-9
+#define CHAR_IDENT  (CHAR_ALPHA | CHAR_DIGIT)
+
+extern const unsigned char char_class[256];
+
+#define is_space_char(c) (char_class[(unsigned char)(c)] & CHAR_SPACE)
+#define is_alpha_char(c) (char_class[(unsigned char)(c)] & CHAR_ALPHA)
+#define is_digit_char(c) (char_class[(unsigned char)(c)] & CHAR_DIGIT)
+#define is_ident_char(c) (char_class[(unsigned char)(c)] & CHAR_IDENT)
+
+// Each scanner returns the first byte in [p, end) that ends the run, or end.
+// The implementation (AVX2, SSE2 or scalar) is picked on first call via cpuid.
+
+// Run of CHAR_SPACE bytes; never crosses a newline
+extern const char* (*scan_whitespace)(const char* p, const char* end);
+
+// Run of CHAR_IDENT bytes
+extern const char* (*scan_identifier)(const char* p, const char* end);
+
+// String body up to the next '"' or '\\'
+extern const char* (*scan_string)(const char* p, const char* end);
+
+// Up to the next byte that can change brace depth: '{', '}', '"' or '/'
+extern const char* (*scan_structure)(const char* p, const char* end);
+
+// Name of the active implementation: "avx2", "sse2" or "scalar"
+const char* scan_implementation(void);
+
+// Switch to a slower implementation (e.g. "scalar") for comparisons
+bool scan_force_implementation(const char* name);
+
+#endif
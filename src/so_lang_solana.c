@@ -4,366 +4,768 @@
  */
 
 #include "so_lang_solana.h"
-
-// Global Solana compiler state
-static SolanaCompiler* current_solana_compiler = NULL;
-static bool in_program_context = false;
-static bool in_instruction_handler = false;
+#include "so_lang_parser.h"
+#include "so_lang_emit.h"
 
 // ============================================================================
-// SOLANA AST FUNCTIONS
+// TYPE LAYOUTS
 // ============================================================================
 
-SolanaASTNode* solana_ast_create_node(NodeType type) {
-    SolanaASTNode* node = malloc(sizeof(SolanaASTNode));
-    node->type = type;
-    node->value[0] = '\0';
-    node->left = NULL;
-    node->right = NULL;
-    node->condition = NULL;
-    node->then_branch = NULL;
-    node->else_branch = NULL;
-    node->children = NULL;
-    node->child_count = 0;
+// Room reserved in an account for a string or byte vector: a u32 length
+// and this many bytes
+#define LAYOUT_DYNAMIC_CAPACITY 64
+
+// Built-in types: source name, Rust spelling and Borsh size and alignment.
+// Types without a source name only come from the compiler itself
+static const struct {
+    const char* name;
+    const char* rust;
+    int size;
+    int align;
+} solana_types[] = {
+    [SOLANA_TYPE_PUBKEY]       = {"pubkey",   "Pubkey",      32, 1},
+    [SOLANA_TYPE_LAMPORTS]     = {"lamports", "u64",         8,  8},
+    [SOLANA_TYPE_U64]          = {"u64",      "u64",         8,  8},
+    [SOLANA_TYPE_U32]          = {"u32",      "u32",         4,  4},
+    [SOLANA_TYPE_U8]           = {"u8",       "u8",          1,  1},
+    [SOLANA_TYPE_STRING]       = {"string",   "String",      4 + LAYOUT_DYNAMIC_CAPACITY, 4},
+    [SOLANA_TYPE_BOOL]         = {"bool",     "bool",        1,  1},
+    [SOLANA_TYPE_ACCOUNT_INFO] = {NULL,       "AccountInfo", 0,  1},
+    [SOLANA_TYPE_INSTRUCTION]  = {NULL,       "Instruction", 0,  1},
+    [SOLANA_TYPE_PROGRAM_ID]   = {NULL,       "Pubkey",      32, 1},
+    [SOLANA_TYPE_U16]          = {"u16",      "u16",         2,  2},
+    [SOLANA_TYPE_U128]         = {"u128",     "u128",        16, 16},
+    [SOLANA_TYPE_I8]           = {"i8",       "i8",          1,  1},
+    [SOLANA_TYPE_I16]          = {"i16",      "i16",         2,  2},
+    [SOLANA_TYPE_I32]          = {"i32",      "i32",         4,  4},
+    [SOLANA_TYPE_I64]          = {"i64",      "i64",         8,  8},
+    [SOLANA_TYPE_I128]         = {"i128",     "i128",        16, 16},
+    [SOLANA_TYPE_BYTES]        = {"bytes",    "Vec<u8>",     4 + LAYOUT_DYNAMIC_CAPACITY, 4},
+    [SOLANA_TYPE_DEFINED]      = {NULL,       NULL,          0,  1},
+};
+
+// Declarations that carry a TypeLayout; one without a name has none
+static bool solana_is_type_declaration(const ASTNode* node) {
+    return (node->type == NODE_STATE_DECL || node->type == NODE_EVENT_DECL ||
+            node->type == NODE_ENUM_DECL || node->type == NODE_ERROR_DECL) && node->as.layout;
+}
+
+static TypeLayout* layout_find(TypeLayout** layouts, int count, Symbol name) {
+    for (int i = 0; i < count; i++) {
+        if (layouts[i]->name == name) return layouts[i];
+    }
+    return NULL;
+}
+
+// Packs the fields in order, sizing declared field types first. Enums are
+// a one-byte variant index and errors a u32 code; neither has offsets
+static void layout_compute(TypeLayout** layouts, int count, TypeLayout* layout) {
+    if (layout->status == LAYOUT_DONE) return;
+    layout->status = LAYOUT_SIZING;
+    layout->align = 1;
     
-    node->solana_type = SOLANA_TYPE_U64;
-    node->constraint_type = CONSTRAINT_SIGNER;
-    node->account_name = NULL;
-    node->instruction_name = NULL;
-    node->program_id = NULL;
-    node->is_signer = false;
-    node->is_writable = false;
-    node->is_init = false;
-    node->seeds = NULL;
-    node->seed_count = 0;
-    node->bump = 0;
+    if (layout->kind == NODE_ENUM_DECL || layout->kind == NODE_ERROR_DECL) {
+        layout->size = layout->align = layout->kind == NODE_ENUM_DECL ? 1 : 4;
+        layout->status = LAYOUT_DONE;
+        return;
+    }
     
-    return node;
+    int offset = 0;
+    for (int i = 0; i < layout->field_count; i++) {
+        TypeField* field = &layout->fields[i];
+        
+        if (field->solana_type != SOLANA_TYPE_DEFINED) {
+            field->size = solana_types[field->solana_type].size;
+            field->align = solana_types[field->solana_type].align;
+        } else {
+            TypeLayout* type = layout_find(layouts, count, field->type_name);
+            if (!type || type->kind == NODE_ERROR_DECL) {
+                diag_report(DIAG_UNKNOWN_TYPE, field->type_span.start, field->type_span.length, "Unknown type");
+            } else if (type->status == LAYOUT_SIZING) {
+                diag_report(DIAG_UNKNOWN_TYPE, field->type_span.start, field->type_span.length,
+                            "A type cannot contain itself");
+            } else {
+                layout_compute(layouts, count, type);
+                field->size = type->size;
+                field->align = type->align;
+            }
+        }
+        
+        field->offset = offset;
+        offset += field->size;
+        if (field->align > layout->align) layout->align = field->align;
+    }
+    
+    layout->size = offset;
+    layout->status = LAYOUT_DONE;
 }
 
-void solana_ast_free(SolanaASTNode* node) {
-    if (!node) return;
-    
-    solana_ast_free((SolanaASTNode*)node->left);
-    solana_ast_free((SolanaASTNode*)node->right);
-    solana_ast_free((SolanaASTNode*)node->condition);
-    solana_ast_free((SolanaASTNode*)node->then_branch);
-    solana_ast_free((SolanaASTNode*)node->else_branch);
+static void layout_link_account(TypeLayout** layouts, int count, InstructionParam* account) {
+    if (account->solana_type != SOLANA_TYPE_DEFINED) return;
     
-    if (node->children) {
-        for (int i = 0; i < node->child_count; i++) {
-            solana_ast_free((SolanaASTNode*)node->children[i]);
+    TypeLayout* type = layout_find(layouts, count, account->type_name);
+    if (type && type->kind == NODE_STATE_DECL) account->layout = type;
+}
+
+// Adds the layouts declared directly in list, a file or a program body
+static TypeLayout** layout_collect(Arena* arena, TypeLayout** layouts, int* count, const ASTNode* list) {
+    for (int i = 0; i < list->as.list.count; i++) {
+        ASTNode* item = list->as.list.items[i];
+        if (!solana_is_type_declaration(item)) continue;
+        
+        layouts = arena_list_grow(arena, layouts, *count, sizeof(TypeLayout*));
+        layouts[(*count)++] = item->as.layout;
+    }
+    return layouts;
+}
+
+static void layout_link_program(TypeLayout** layouts, int count, const ASTNode* program) {
+    for (int i = 0; i < program->as.list.count; i++) {
+        ASTNode* item = program->as.list.items[i];
+        
+        if (item->type == NODE_ACCOUNT_DECL) {
+            layout_link_account(layouts, count, item->as.account);
+        } else if (item->type == NODE_INSTRUCTION_DECL && item->as.instruction.params) {
+            ParamTable* params = item->as.instruction.params;
+            for (int j = 0; j < params->count; j++) {
+                if (params->items[j].is_account) layout_link_account(layouts, count, &params->items[j]);
+            }
         }
-        free(node->children);
     }
+}
+
+// Runs once the whole file is parsed: sizes every type declared in it,
+// inside the program or after it, and points each account at the layout of
+// its state type, so emitters only read
+static void solana_link_layouts(Arena* arena, ASTNode* file) {
+    TypeLayout** layouts = arena_alloc(arena, sizeof(TypeLayout*) * AST_LIST_INLINE);
+    int count = 0;
     
-    if (node->account_name) free(node->account_name);
-    if (node->instruction_name) free(node->instruction_name);
-    if (node->program_id) free(node->program_id);
-    if (node->seeds) {
-        for (int i = 0; i < node->seed_count; i++) {
-            free(node->seeds[i]);
+    for (int i = 0; i < file->as.list.count; i++) {
+        if (file->as.list.items[i]->type == NODE_PROGRAM_DECL) {
+            layouts = layout_collect(arena, layouts, &count, file->as.list.items[i]);
         }
-        free(node->seeds);
+    }
+    layouts = layout_collect(arena, layouts, &count, file);
+    
+    for (int i = 0; i < count; i++) {
+        layout_compute(layouts, count, layouts[i]);
     }
     
-    free(node);
+    for (int i = 0; i < file->as.list.count; i++) {
+        if (file->as.list.items[i]->type == NODE_PROGRAM_DECL) {
+            layout_link_program(layouts, count, file->as.list.items[i]);
+        }
+    }
 }
 
 // ============================================================================
-// ENHANCED LEXER FOR SOLANA
+// SOLANA PARSER
 // ============================================================================
 
-static void solana_lexer_read_attribute(Lexer* lexer) {
-    char buffer[MAX_TOKEN_LEN];
-    int i = 0;
-    
-    lexer_advance(lexer); // Skip '@'
+// Instruction-level recovery: a broken declaration is skipped up to the next
+// declaration keyword, or the '}' that closes the program
+static void solana_synchronize(Parser* parser) {
+    parser->panicking = false;
     
-    while (isalnum(lexer_current_char(lexer)) || lexer_current_char(lexer) == '_') {
-        if (i < MAX_TOKEN_LEN - 1) {
-            buffer[i++] = lexer_current_char(lexer);
+    for (;;) {
+        TokenType type = parser_current_token(parser)->type;
+        if (type == TOKEN_INSTRUCTION || type == TOKEN_ACCOUNT || type == TOKEN_STATE ||
+            type == TOKEN_EVENT || type == TOKEN_ERROR || type == TOKEN_RBRACE || type == TOKEN_EOF) {
+            return;
         }
-        lexer_advance(lexer);
+        parser_advance(parser);
     }
+}
+
+// Declarations up to the program's '}' or the end of the lexer's range
+static void solana_parse_program_body(Parser* parser, ASTNode* program) {
+    while (!diag_limit_reached() &&
+           parser_current_token(parser)->type != TOKEN_RBRACE && 
+           parser_current_token(parser)->type != TOKEN_EOF) {
+        
+        if (parser_match(parser, TOKEN_NEWLINE)) continue;
+        
+        int start = parser->lexer->ring_head;
+        ASTNode* stmt = solana_parser_parse(parser);
+        if (stmt) {
+            ast_list_append(parser->arena, program, stmt);
+        }
+        if (parser->panicking || parser->lexer->ring_head == start) {
+            solana_synchronize(parser);
+        }
+    }
+}
+
+typedef struct {
+    char* source;
+    LexerDialect dialect;
+    const int* bounds;
+    ASTNode** pieces;
+    int* token_counts;
+    int* ends;              // Each piece's last token end
+    Arena* arenas;          // One per worker
+} SolanaParallelParse;
+
+static void solana_parse_piece(void* context, int worker, int task) {
+    SolanaParallelParse* job = context;
+    Lexer* lexer = lexer_create_range(job->source, job->bounds[task], job->bounds[task + 1], job->dialect);
+    Parser* parser = parser_create(lexer, &job->arenas[worker]);
     
-    buffer[i] = '\0';
+    job->pieces[task] = ast_create_list_node(parser->arena, NODE_PROGRAM_DECL);
+    solana_parse_program_body(parser, job->pieces[task]);
+    job->token_counts[task] = lexer->token_count;
+    job->ends[task] = parser->previous_end;
     
-    if (strcmp(buffer, "program") == 0) {
-        lexer_add_token(lexer, TOKEN_PROGRAM, buffer);
-    } else if (strcmp(buffer, "instruction") == 0) {
-        lexer_add_token(lexer, TOKEN_INSTRUCTION, buffer);
-    } else if (strcmp(buffer, "account") == 0) {
-        lexer_add_token(lexer, TOKEN_ACCOUNT, buffer);
-    } else if (strcmp(buffer, "signer") == 0) {
-        lexer_add_token(lexer, TOKEN_SIGNER, buffer);
-    } else if (strcmp(buffer, "writable") == 0) {
-        lexer_add_token(lexer, TOKEN_WRITABLE, buffer);
-    } else if (strcmp(buffer, "init") == 0) {
-        lexer_add_token(lexer, TOKEN_INIT, buffer);
-    } else {
-        lexer_add_token(lexer, TOKEN_IDENTIFIER, buffer);
-    }
-}
-
-static void solana_lexer_read_solana_identifier(Lexer* lexer) {
-    char buffer[MAX_TOKEN_LEN];
-    int i = 0;
-    
-    while (isalnum(lexer_current_char(lexer)) || lexer_current_char(lexer) == '_') {
-        if (i < MAX_TOKEN_LEN - 1) {
-            buffer[i++] = lexer_current_char(lexer);
-        }
-        lexer_advance(lexer);
-    }
-    
-    buffer[i] = '\0';
-    
-    TokenType type = TOKEN_IDENTIFIER;
-    if (strcmp(buffer, "program") == 0) type = TOKEN_PROGRAM;
-    else if (strcmp(buffer, "instruction") == 0) type = TOKEN_INSTRUCTION;
-    else if (strcmp(buffer, "account") == 0) type = TOKEN_ACCOUNT;
-    else if (strcmp(buffer, "state") == 0) type = TOKEN_STATE;
-    else if (strcmp(buffer, "pubkey") == 0) type = TOKEN_PUBKEY;
-    else if (strcmp(buffer, "lamports") == 0) type = TOKEN_LAMPORTS;
-    else if (strcmp(buffer, "signer") == 0) type = TOKEN_SIGNER;
-    else if (strcmp(buffer, "writable") == 0) type = TOKEN_WRITABLE;
-    else if (strcmp(buffer, "init") == 0) type = TOKEN_INIT;
-    else if (strcmp(buffer, "seeds") == 0) type = TOKEN_SEEDS;
-    else if (strcmp(buffer, "bump") == 0) type = TOKEN_BUMP;
-    else if (strcmp(buffer, "pda") == 0) type = TOKEN_PDA;
-    else if (strcmp(buffer, "transfer") == 0) type = TOKEN_TRANSFER;
-    else if (strcmp(buffer, "invoke") == 0) type = TOKEN_INVOKE;
-    else if (strcmp(buffer, "require") == 0) type = TOKEN_REQUIRE;
-    else if (strcmp(buffer, "error") == 0) type = TOKEN_ERROR;
-    else if (strcmp(buffer, "event") == 0) type = TOKEN_EVENT;
-    else if (strcmp(buffer, "emit") == 0) type = TOKEN_EMIT;
-    else if (strcmp(buffer, "anchor") == 0) type = TOKEN_ANCHOR;
-    else if (strcmp(buffer, "solana") == 0) type = TOKEN_SOLANA;
-    else if (strcmp(buffer, "entrypoint") == 0) type = TOKEN_ENTRYPOINT;
-    
-    lexer_add_token(lexer, type, buffer);
-}
-
-void solana_lexer_tokenize(Lexer* lexer) {
-    while (lexer_current_char(lexer) != '\0') {
-        char c = lexer_current_char(lexer);
-        
-        if (isspace(c) && c != '\n') {
-            lexer_skip_whitespace(lexer);
-        } else if (c == '\n') {
-            lexer_add_token(lexer, TOKEN_NEWLINE, "\n");
-            lexer_advance(lexer);
-        } else if (c == '@') {
-            solana_lexer_read_attribute(lexer);
-        } else if (c == '#') {
-            lexer_add_token(lexer, TOKEN_HASH, "#");
-            lexer_advance(lexer);
-        } else if (c == '-' && lexer->source[lexer->pos + 1] == '>') {
-            lexer_add_token(lexer, TOKEN_ARROW, "->");
-            lexer_advance(lexer);
-            lexer_advance(lexer);
-        } else if (c == '"') {
-            lexer_read_string(lexer);
-        } else if (isalpha(c) || c == '_') {
-            solana_lexer_read_solana_identifier(lexer);
-        } else if (isdigit(c)) {
-            lexer_read_number(lexer);
-        } else {
-            char token_str[2] = {c, '\0'};
-            switch (c) {
-                case '=': lexer_add_token(lexer, TOKEN_ASSIGN, token_str); break;
-                case '+': lexer_add_token(lexer, TOKEN_PLUS, token_str); break;
-                case '-': lexer_add_token(lexer, TOKEN_MINUS, token_str); break;
-                case '*': lexer_add_token(lexer, TOKEN_MULTIPLY, token_str); break;
-                case '/': lexer_add_token(lexer, TOKEN_DIVIDE, token_str); break;
-                case '<': lexer_add_token(lexer, TOKEN_LESS, token_str); break;
-                case '>': lexer_add_token(lexer, TOKEN_GREATER, token_str); break;
-                case '(': lexer_add_token(lexer, TOKEN_LPAREN, token_str); break;
-                case ')': lexer_add_token(lexer, TOKEN_RPAREN, token_str); break;
-                case '{': lexer_add_token(lexer, TOKEN_LBRACE, token_str); break;
-                case '}': lexer_add_token(lexer, TOKEN_RBRACE, token_str); break;
-                case ',': lexer_add_token(lexer, TOKEN_COMMA, token_str); break;
-                case ';': lexer_add_token(lexer, TOKEN_SEMICOLON, token_str); break;
-                default:
-                    error("Unexpected character", lexer->line, lexer->column);
-                    break;
+    parser_free(parser);
+    lexer_free(lexer);
+}
+
+// The program body's declarations are independent until layouts are linked,
+// so a large body is cut between them and parsed on parser->jobs threads,
+// as parser_parse does for a core file. False, with nothing consumed, if the
+// body is small or any piece reports an error; the caller then parses it
+// sequentially so diagnostics come out as they always have
+static bool solana_parse_program_parallel(Parser* parser, ASTNode* program) {
+    Lexer* lexer = parser->lexer;
+    Token* first = parser_current_token(parser);
+    int start = first->start;
+    int end = (int)(lexer->end - lexer->source);
+    
+    // Only the current token may be buffered, or it would be lexed twice
+    if (lexer->token_count - lexer->ring_head != 1 || end - start < 2 * PARALLEL_MIN_CHUNK) return false;
+    
+    int min_chunk = (end - start) / (parser->jobs * 4);
+    if (min_chunk < PARALLEL_MIN_CHUNK) min_chunk = PARALLEL_MIN_CHUNK;
+    
+    DeclarationSplit split;
+    if (!split_declarations(lexer->source, start, end, min_chunk, &split)) return false;
+    if (split.count < 2) {
+        split_free(&split);
+        return false;
+    }
+    
+    SolanaParallelParse job = {
+        .source = lexer->source,
+        .dialect = lexer->dialect,
+        .bounds = split.bounds,
+        .pieces = calloc(split.count, sizeof(ASTNode*)),
+        .token_counts = calloc(split.count, sizeof(int)),
+        .ends = calloc(split.count, sizeof(int)),
+        .arenas = calloc(parser->jobs, sizeof(Arena)),
+    };
+    for (int i = 0; i < parser->jobs; i++) {
+        arena_init(&job.arenas[i]);
+    }
+    
+    parallel_for(split.count, parser->jobs, solana_parse_piece, &job);
+    
+    bool parsed = diag_error_count() == 0;
+    if (parsed) {
+        // The buffered token was lexed again by the first piece, and each
+        // piece counted an EOF of its own
+        int tokens = lexer->token_count - 1;
+        
+        for (int i = 0; i < split.count; i++) {
+            ASTNode* piece = job.pieces[i];
+            for (int j = 0; j < piece->as.list.count; j++) {
+                ast_list_append(parser->arena, program, piece->as.list.items[j]);
             }
-            lexer_advance(lexer);
+            if (job.ends[i] > parser->previous_end) parser->previous_end = job.ends[i];
+            tokens += job.token_counts[i] - 1;
+        }
+        for (int i = 0; i < parser->jobs; i++) {
+            arena_adopt(parser->arena, &job.arenas[i]);
+        }
+        
+        // Carry on at the program's '}'
+        lexer->token_count = tokens;
+        lexer_seek(lexer, split.end);
+    } else {
+        diag_reset();
+        for (int i = 0; i < parser->jobs; i++) {
+            arena_free(&job.arenas[i]);
         }
     }
     
-    lexer_add_token(lexer, TOKEN_EOF, "");
+    free(job.pieces);
+    free(job.token_counts);
+    free(job.ends);
+    free(job.arenas);
+    split_free(&split);
+    return parsed;
 }
 
-// ============================================================================
-// SOLANA PARSER
-// ============================================================================
-
-static SolanaASTNode* solana_parse_program_declaration(Parser* parser) {
-    parser_advance(parser); // consume 'program'
+static ASTNode* solana_parse_program_declaration(Parser* parser) {
+    int program_start = parser_advance(parser)->start; // consume 'program'
     
-    SolanaASTNode* program = solana_ast_create_node(NODE_PROGRAM_DECL);
+    ASTNode* program = ast_create_list_node(parser->arena, NODE_PROGRAM_DECL);
     
     Token* name = parser_current_token(parser);
     if (name->type == TOKEN_IDENTIFIER) {
-        strcpy(program->value, name->value);
+        program->value = token_symbol(parser->source, name);
         parser_advance(parser);
     }
     
     if (parser_match(parser, TOKEN_LPAREN)) {
         Token* id = parser_current_token(parser);
         if (id->type == TOKEN_STRING) {
-            program->program_id = malloc(strlen(id->value) + 1);
-            strcpy(program->program_id, id->value);
+            program->as.list.program_id = token_symbol(parser->source, id);
             parser_advance(parser);
         }
         parser_match(parser, TOKEN_RPAREN);
     }
     
     if (parser_match(parser, TOKEN_LBRACE)) {
-        program->children = malloc(sizeof(SolanaASTNode*) * 100);
-        program->child_count = 0;
-        
-        in_program_context = true;
-        
-        while (parser_current_token(parser)->type != TOKEN_RBRACE && 
-               parser_current_token(parser)->type != TOKEN_EOF) {
-            
-            if (parser_match(parser, TOKEN_NEWLINE)) continue;
-            
-            SolanaASTNode* stmt = (SolanaASTNode*)solana_parser_parse(parser);
-            if (stmt && program->child_count < 100) {
-                program->children[program->child_count++] = stmt;
-            }
+        if (parser->jobs <= 1 || !solana_parse_program_parallel(parser, program)) {
+            solana_parse_program_body(parser, program);
         }
-        
-        in_program_context = false;
         parser_match(parser, TOKEN_RBRACE);
     }
     
+    parser_span(parser, program, program_start);
     return program;
 }
 
-static SolanaASTNode* solana_parse_instruction_declaration(Parser* parser) {
-    parser_advance(parser); // consume 'instruction'
+static void solana_skip_newlines(Parser* parser) {
+    while (parser_match(parser, TOKEN_NEWLINE)) {}
+}
+
+// Solana keywords double as field, parameter and type names (`bump: u8`,
+// `user: pubkey`), so any word is accepted where a name is expected
+static bool solana_is_name(const Token* token) {
+    return token->type == TOKEN_IDENTIFIER ||
+           (token->type >= TOKEN_PROGRAM && token->type <= TOKEN_CLOCK);
+}
+
+// Anything that is not a built-in names a declared or an external type.
+// Matched on the token's text: symbol_text may not be called while the
+// program body is parsed on several threads
+static SolanaDataType solana_type_from_token(const char* source, const Token* token) {
+    for (size_t i = 0; i < sizeof(solana_types) / sizeof(solana_types[0]); i++) {
+        if (solana_types[i].name && token_equals(source, token, solana_types[i].name)) return (SolanaDataType)i;
+    }
+    return SOLANA_TYPE_DEFINED;
+}
+
+// The type after a ':'; false (with an error) if there is none
+static bool solana_parse_type(Parser* parser, Symbol* type_name, uint8_t* solana_type) {
+    Token* type = parser_current_token(parser);
+    if (!solana_is_name(type)) {
+        parser_error(parser, DIAG_EXPECTED_TOKEN, type, "Expected a type");
+        return false;
+    }
     
-    SolanaASTNode* instruction = solana_ast_create_node(NODE_INSTRUCTION_DECL);
+    *type_name = token_symbol(parser->source, type);
+    *solana_type = solana_type_from_token(parser->source, type);
+    parser_advance(parser);
+    return true;
+}
+
+// seeds = [expr, ...]; cur is on the '['
+static void solana_parse_seeds(Parser* parser, AccountConstraint* constraint) {
+    if (!parser_expect(parser, TOKEN_LBRACKET, "Expected '[' after 'seeds ='")) return;
     
-    Token* name = parser_current_token(parser);
-    if (name->type == TOKEN_IDENTIFIER) {
-        strcpy(instruction->value, name->value);
-        instruction->instruction_name = malloc(strlen(name->value) + 1);
-        strcpy(instruction->instruction_name, name->value);
+    ASTNode** seeds = arena_alloc(parser->arena, sizeof(ASTNode*) * AST_LIST_INLINE);
+    int count = 0;
+    
+    while (parser_current_token(parser)->type != TOKEN_RBRACKET &&
+           parser_current_token(parser)->type != TOKEN_EOF) {
+        ASTNode* seed = parser_parse_expression(parser);
+        if (!seed) break;
+        
+        seeds = arena_list_grow(parser->arena, seeds, count, sizeof(ASTNode*));
+        seeds[count++] = seed;
+        if (!parser_match(parser, TOKEN_COMMA)) break;
+    }
+    
+    parser_expect(parser, TOKEN_RBRACKET, "Expected ']' after the seeds");
+    constraint->seeds = seeds;
+    constraint->seed_count = count;
+}
+
+// One entry of a constraint list: a flag, `seeds = [...]`, `space = expr`,
+// or `name = account` / `token::name = account`
+static void solana_parse_constraint(Parser* parser, AccountConstraint* constraint) {
+    Token* token = parser_current_token(parser);
+    
+    switch (token->type) {
+        case TOKEN_SIGNER:
+            constraint->is_signer = true;
+            parser_advance(parser);
+            return;
+        case TOKEN_WRITABLE:
+            constraint->is_writable = true;
+            parser_advance(parser);
+            return;
+        case TOKEN_INIT:
+            constraint->is_init = true;
+            parser_advance(parser);
+            return;
+        case TOKEN_BUMP:
+            constraint->has_bump = true;
+            parser_advance(parser);
+            return;
+        case TOKEN_SEEDS:
+            parser_advance(parser);
+            if (parser_expect(parser, TOKEN_ASSIGN, "Expected '=' after 'seeds'")) {
+                solana_parse_seeds(parser, constraint);
+            }
+            return;
+        case TOKEN_IDENTIFIER:
+            break;
+        default:
+            parser_error(parser, DIAG_UNEXPECTED_TOKEN, token, "Unknown account constraint");
+            return;
+    }
+    
+    // Copied out: the ring may move on before the key is looked at
+    Token key = *token;
+    bool in_token = false;
+    parser_advance(parser);
+    
+    if (token_equals(parser->source, &key, "token") && parser_match(parser, TOKEN_DOUBLE_COLON)) {
+        key = *parser_current_token(parser);
+        in_token = true;
         parser_advance(parser);
     }
     
+    bool is_space = !in_token && token_equals(parser->source, &key, "space");
+    Symbol* target = NULL;
+    if (!in_token && token_equals(parser->source, &key, "payer")) {
+        target = &constraint->payer;
+    } else if (in_token && token_equals(parser->source, &key, "mint")) {
+        target = &constraint->token_mint;
+    } else if (in_token && token_equals(parser->source, &key, "authority")) {
+        target = &constraint->token_authority;
+    }
+    
+    if (!is_space && !target) {
+        parser_error(parser, DIAG_UNEXPECTED_TOKEN, &key, "Unknown account constraint");
+        return;
+    }
+    if (!parser_expect(parser, TOKEN_ASSIGN, "Expected '=' after the constraint name")) return;
+    
+    if (is_space) {
+        constraint->space = parser_parse_expression(parser);
+        return;
+    }
+    
+    Token* value = parser_current_token(parser);
+    if (value->type != TOKEN_IDENTIFIER) {
+        parser_error(parser, DIAG_EXPECTED_TOKEN, value, "Expected an account name");
+        return;
+    }
+    *target = token_symbol(parser->source, value);
+    parser_advance(parser);
+}
+
+// `(constraint, ...)`; without the parentheses the account has none
+static void solana_parse_constraints(Parser* parser, AccountConstraint* constraint) {
+    if (!parser_match(parser, TOKEN_LPAREN)) return;
+    solana_skip_newlines(parser);
+    
+    while (parser_current_token(parser)->type != TOKEN_RPAREN &&
+           parser_current_token(parser)->type != TOKEN_EOF) {
+        solana_parse_constraint(parser, constraint);
+        solana_skip_newlines(parser);
+        if (parser->panicking || !parser_match(parser, TOKEN_COMMA)) break;
+        solana_skip_newlines(parser);
+    }
+    
+    // After an error, the rest of the list is skipped
+    while (parser->panicking &&
+           parser_current_token(parser)->type != TOKEN_RPAREN &&
+           parser_current_token(parser)->type != TOKEN_EOF) {
+        parser_advance(parser);
+    }
+    parser_expect(parser, TOKEN_RPAREN, "Expected ')' after the account constraints");
+}
+
+// [@account[(constraints)]] name: type
+static void solana_parse_param(Parser* parser, InstructionParam* param) {
+    if (parser_match(parser, TOKEN_ACCOUNT)) {
+        param->is_account = true;
+        solana_parse_constraints(parser, &param->constraint);
+        if (parser->panicking) return;
+    }
+    
+    Token* name = parser_current_token(parser);
+    if (!solana_is_name(name)) {
+        parser_error(parser, DIAG_EXPECTED_TOKEN, name, "Expected parameter name");
+        return;
+    }
+    param->name = token_symbol(parser->source, name);
+    parser_advance(parser);
+    
+    if (parser_expect(parser, TOKEN_COLON, "Expected ':' and a type after the parameter name")) {
+        solana_parse_type(parser, &param->type_name, &param->solana_type);
+    }
+}
+
+// Without `payer =`, the first signer not itself being created pays for
+// `init`. Filled in while parsing: codegen may run on several threads and
+// must not intern
+static void solana_default_payer(InstructionParam* params, int count) {
+    Symbol payer = SYMBOL_NONE;
+    for (int i = 0; i < count && payer == SYMBOL_NONE; i++) {
+        const AccountConstraint* constraint = &params[i].constraint;
+        if (params[i].is_account && constraint->is_signer && !constraint->is_init) {
+            payer = params[i].name;
+        }
+    }
+    
+    for (int i = 0; i < count; i++) {
+        AccountConstraint* constraint = &params[i].constraint;
+        if (!constraint->is_init || constraint->payer != SYMBOL_NONE) continue;
+        if (payer == SYMBOL_NONE) payer = symbol_intern("payer", 5);
+        constraint->payer = payer;
+    }
+}
+
+// The whole parameter list. Parameters are collected in a small vector and
+// then copied into a table of exactly the right size
+static ParamTable* solana_parse_params(Parser* parser) {
+    InstructionParam* params = arena_alloc(parser->arena, sizeof(InstructionParam) * AST_LIST_INLINE);
+    int count = 0;
+    int account_count = 0;
+    
     if (parser_match(parser, TOKEN_LPAREN)) {
+        solana_skip_newlines(parser);
+        
         while (parser_current_token(parser)->type != TOKEN_RPAREN &&
+               parser_current_token(parser)->type != TOKEN_LBRACE &&
                parser_current_token(parser)->type != TOKEN_EOF) {
-            parser_advance(parser); // Skip for now
+            params = arena_list_grow(parser->arena, params, count, sizeof(InstructionParam));
+            InstructionParam* param = &params[count++];
+            solana_parse_param(parser, param);
+            if (param->is_account) account_count++;
+            
+            solana_skip_newlines(parser);
+            if (parser->panicking || !parser_match(parser, TOKEN_COMMA)) break;
+            solana_skip_newlines(parser);
+        }
+        
+        // A broken list is skipped up to the body rather than swallowing it
+        if (parser_current_token(parser)->type != TOKEN_RPAREN) {
+            parser_error(parser, DIAG_EXPECTED_TOKEN, parser_current_token(parser), "Expected ')' after parameters");
+            while (parser_current_token(parser)->type != TOKEN_RPAREN &&
+                   parser_current_token(parser)->type != TOKEN_LBRACE &&
+                   parser_current_token(parser)->type != TOKEN_EOF) {
+                parser_advance(parser);
+            }
         }
         parser_match(parser, TOKEN_RPAREN);
     }
     
-    if (parser_match(parser, TOKEN_LBRACE)) {
-        instruction->left = (struct SolanaASTNode*)solana_parser_parse(parser);
-        parser_match(parser, TOKEN_RBRACE);
-    }
-    
-    return instruction;
+    ParamTable* table = arena_alloc(parser->arena, sizeof(ParamTable) + sizeof(InstructionParam) * count);
+    table->count = count;
+    table->account_count = account_count;
+    memcpy(table->items, params, sizeof(InstructionParam) * count);
+    solana_default_payer(table->items, count);
+    return table;
 }
 
-static SolanaASTNode* solana_parse_account_declaration(Parser* parser) {
-    parser_advance(parser); // consume 'account'
+static ASTNode* solana_parse_instruction_declaration(Parser* parser) {
+    int start = parser_advance(parser)->start; // consume 'instruction'
     
-    SolanaASTNode* account = solana_ast_create_node(NODE_ACCOUNT_DECL);
+    ASTNode* instruction = ast_create_node(parser->arena, NODE_INSTRUCTION_DECL);
     
     Token* name = parser_current_token(parser);
     if (name->type == TOKEN_IDENTIFIER) {
-        strcpy(account->value, name->value);
-        account->account_name = malloc(strlen(name->value) + 1);
-        strcpy(account->account_name, name->value);
+        instruction->value = token_symbol(parser->source, name);
         parser_advance(parser);
     }
     
-    if (parser_match(parser, TOKEN_LPAREN)) {
-        while (parser_current_token(parser)->type != TOKEN_RPAREN &&
+    instruction->as.instruction.params = solana_parse_params(parser);
+    
+    // The body is a list of statements, like a program's
+    if (parser_expect(parser, TOKEN_LBRACE, "Expected '{' before the instruction body")) {
+        ASTNode* body = ast_create_list_node(parser->arena, NODE_PROGRAM);
+        parser->panicking = false;
+        
+        while (!diag_limit_reached() &&
+               parser_current_token(parser)->type != TOKEN_RBRACE &&
                parser_current_token(parser)->type != TOKEN_EOF) {
+            if (parser_match(parser, TOKEN_NEWLINE)) continue;
             
-            Token* constraint = parser_current_token(parser);
-            if (constraint->type == TOKEN_SIGNER) {
-                account->is_signer = true;
-            } else if (constraint->type == TOKEN_WRITABLE) {
-                account->is_writable = true;
-            } else if (constraint->type == TOKEN_INIT) {
-                account->is_init = true;
+            int before = parser->lexer->ring_head;
+            ASTNode* stmt = solana_parser_parse(parser);
+            if (stmt) {
+                ast_list_append(parser->arena, body, stmt);
             }
-            parser_advance(parser);
-            
-            if (parser_match(parser, TOKEN_COMMA)) continue;
+            parser_recover(parser, before);
         }
-        parser_match(parser, TOKEN_RPAREN);
+        
+        instruction->as.instruction.body = body;
+        parser_expect(parser, TOKEN_RBRACE, "Expected '}' after the instruction body");
     }
     
-    if (parser_match(parser, TOKEN_COLON)) {
-        Token* type = parser_current_token(parser);
-        if (type->type == TOKEN_PUBKEY) {
-            account->solana_type = SOLANA_TYPE_PUBKEY;
-        } else if (type->type == TOKEN_LAMPORTS) {
-            account->solana_type = SOLANA_TYPE_LAMPORTS;
-        }
+    parser_span(parser, instruction, start);
+    return instruction;
+}
+
+static ASTNode* solana_parse_account_declaration(Parser* parser) {
+    int start = parser_advance(parser)->start; // consume 'account'
+    
+    ASTNode* account = ast_create_node(parser->arena, NODE_ACCOUNT_DECL);
+    InstructionParam* declared = arena_alloc(parser->arena, sizeof(InstructionParam));
+    declared->is_account = true;
+    declared->solana_type = SOLANA_TYPE_ACCOUNT_INFO;
+    account->as.account = declared;
+    
+    Token* name = parser_current_token(parser);
+    if (name->type == TOKEN_IDENTIFIER) {
+        account->value = token_symbol(parser->source, name);
+        declared->name = account->value;
         parser_advance(parser);
     }
     
+    solana_parse_constraints(parser, &declared->constraint);
+    solana_default_payer(declared, 1);
+    
+    if (parser_match(parser, TOKEN_COLON)) {
+        solana_parse_type(parser, &declared->type_name, &declared->solana_type);
+    }
+    
+    parser_span(parser, account, start);
     return account;
 }
 
-static SolanaASTNode* solana_parse_transfer_statement(Parser* parser) {
-    parser_advance(parser); // consume 'transfer'
+// One entry of a declaration body: `name: type` in states and events, a
+// bare name in enums, `name = "message"` in errors
+static void solana_parse_type_field(Parser* parser, uint8_t kind, TypeField* field) {
+    Token* name = parser_current_token(parser);
+    if (!solana_is_name(name)) {
+        parser_error(parser, DIAG_EXPECTED_TOKEN, name, "Expected a field name");
+        return;
+    }
+    field->name = token_symbol(parser->source, name);
+    parser_advance(parser);
     
-    SolanaASTNode* transfer = solana_ast_create_node(NODE_TRANSFER_STMT);
+    if (kind == NODE_ENUM_DECL) return;
     
-    if (parser_match(parser, TOKEN_LPAREN)) {
-        transfer->left = (struct SolanaASTNode*)parser_parse_expression(parser);
+    if (kind == NODE_ERROR_DECL) {
+        if (!parser_match(parser, TOKEN_ASSIGN)) return;
         
-        if (parser_match(parser, TOKEN_COMMA)) {
-            transfer->right = (struct SolanaASTNode*)parser_parse_expression(parser);
+        Token* message = parser_current_token(parser);
+        if (message->type != TOKEN_STRING) {
+            parser_error(parser, DIAG_EXPECTED_TOKEN, message, "Expected an error message");
+            return;
         }
+        field->type_name = token_symbol(parser->source, message);
+        parser_advance(parser);
+        return;
+    }
+    
+    if (!parser_expect(parser, TOKEN_COLON, "Expected ':' and a type after the field name")) return;
+    
+    Token* type = parser_current_token(parser);
+    field->type_span = (SourceSpan){type->start, type->length};
+    solana_parse_type(parser, &field->type_name, &field->solana_type);
+}
+
+// state, event, enum and error declarations: a name and a braced,
+// comma-separated body, collected into a TypeLayout sized to fit
+static ASTNode* solana_parse_type_declaration(Parser* parser, uint8_t kind) {
+    int start = parser_advance(parser)->start; // consume the keyword
+    
+    ASTNode* decl = ast_create_node(parser->arena, kind);
+    
+    Token* name = parser_current_token(parser);
+    if (name->type != TOKEN_IDENTIFIER) {
+        parser_error(parser, DIAG_EXPECTED_TOKEN, name, "Expected a type name");
+        return decl;
+    }
+    decl->value = token_symbol(parser->source, name);
+    parser_advance(parser);
+    
+    if (!parser_expect(parser, TOKEN_LBRACE, "Expected '{' after the type name")) return decl;
+    
+    TypeField* fields = arena_alloc(parser->arena, sizeof(TypeField) * AST_LIST_INLINE);
+    int count = 0;
+    solana_skip_newlines(parser);
+    
+    while (parser_current_token(parser)->type != TOKEN_RBRACE &&
+           parser_current_token(parser)->type != TOKEN_EOF) {
+        fields = arena_list_grow(parser->arena, fields, count, sizeof(TypeField));
+        solana_parse_type_field(parser, kind, &fields[count++]);
         
-        if (parser_match(parser, TOKEN_COMMA)) {
-            transfer->condition = (struct SolanaASTNode*)parser_parse_expression(parser);
+        solana_skip_newlines(parser);
+        if (parser->panicking || !parser_match(parser, TOKEN_COMMA)) break;
+        solana_skip_newlines(parser);
+    }
+    
+    if (parser_current_token(parser)->type != TOKEN_RBRACE) {
+        parser_error(parser, DIAG_EXPECTED_TOKEN, parser_current_token(parser), "Expected '}' after the declaration body");
+    }
+    
+    // A broken body is skipped whole; the declarations after it still parse
+    while (parser->panicking &&
+           parser_current_token(parser)->type != TOKEN_RBRACE &&
+           parser_current_token(parser)->type != TOKEN_EOF) {
+        parser_advance(parser);
+    }
+    parser_match(parser, TOKEN_RBRACE);
+    parser->panicking = false;
+    
+    TypeLayout* layout = arena_alloc(parser->arena, sizeof(TypeLayout) + sizeof(TypeField) * count);
+    layout->name = decl->value;
+    layout->kind = kind;
+    layout->field_count = count;
+    memcpy(layout->fields, fields, sizeof(TypeField) * count);
+    decl->as.layout = layout;
+    
+    parser_span(parser, decl, start);
+    return decl;
+}
+
+static ASTNode* solana_parse_transfer_statement(Parser* parser) {
+    int start = parser_advance(parser)->start; // consume 'transfer'
+    
+    ASTNode* transfer = ast_create_list_node(parser->arena, NODE_TRANSFER_STMT);
+    
+    if (parser_match(parser, TOKEN_LPAREN)) {
+        // from, to, amount
+        ast_list_append(parser->arena, transfer, parser_parse_expression(parser));
+        
+        while (transfer->as.list.count < 3 && parser_match(parser, TOKEN_COMMA)) {
+            ast_list_append(parser->arena, transfer, parser_parse_expression(parser));
         }
         
         parser_match(parser, TOKEN_RPAREN);
     }
     
+    parser_span(parser, transfer, start);
     return transfer;
 }
 
-static SolanaASTNode* solana_parse_require_statement(Parser* parser) {
-    parser_advance(parser); // consume 'require'
+static ASTNode* solana_parse_require_statement(Parser* parser) {
+    int start = parser_advance(parser)->start; // consume 'require'
     
-    SolanaASTNode* require_stmt = solana_ast_create_node(NODE_REQUIRE_STMT);
+    ASTNode* require_stmt = ast_create_node(parser->arena, NODE_REQUIRE_STMT);
     
     if (parser_match(parser, TOKEN_LPAREN)) {
-        require_stmt->condition = (struct SolanaASTNode*)parser_parse_expression(parser);
+        require_stmt->as.binary.left = parser_parse_expression(parser);
         
+        // A message, or the error to fail with, e.g. TransferError.InvalidAmount
         if (parser_match(parser, TOKEN_COMMA)) {
-            Token* error_msg = parser_current_token(parser);
-            if (error_msg->type == TOKEN_STRING) {
-                strcpy(require_stmt->value, error_msg->value);
-                parser_advance(parser);
+            ASTNode* error = parser_parse_expression(parser);
+            if (error && error->type == NODE_STRING) {
+                require_stmt->value = error->value;
+            } else {
+                require_stmt->as.binary.right = error;
             }
         }
         
-        parser_match(parser, TOKEN_RPAREN);
+        parser_expect(parser, TOKEN_RPAREN, "Expected ')' after the require arguments");
     }
     
+    parser_span(parser, require_stmt, start);
     return require_stmt;
 }
 
-SolanaASTNode* solana_parser_parse(Parser* parser) {
+ASTNode* solana_parser_parse(Parser* parser) {
     Token* token = parser_current_token(parser);
     
     if (token->type == TOKEN_PROGRAM) {
@@ -372,22 +774,201 @@ SolanaASTNode* solana_parser_parse(Parser* parser) {
         return solana_parse_instruction_declaration(parser);
     } else if (token->type == TOKEN_ACCOUNT) {
         return solana_parse_account_declaration(parser);
+    } else if (token->type == TOKEN_STATE) {
+        return solana_parse_type_declaration(parser, NODE_STATE_DECL);
+    } else if (token->type == TOKEN_EVENT) {
+        return solana_parse_type_declaration(parser, NODE_EVENT_DECL);
+    } else if (token->type == TOKEN_ERROR) {
+        return solana_parse_type_declaration(parser, NODE_ERROR_DECL);
+    } else if (token->type == TOKEN_IDENTIFIER && token_equals(parser->source, token, "enum") &&
+               lexer_peek(parser->lexer, 1)->type == TOKEN_IDENTIFIER) {
+        // Not a keyword, so `enum` stays usable as a name elsewhere
+        return solana_parse_type_declaration(parser, NODE_ENUM_DECL);
     } else if (token->type == TOKEN_TRANSFER) {
         return solana_parse_transfer_statement(parser);
     } else if (token->type == TOKEN_REQUIRE) {
         return solana_parse_require_statement(parser);
     } else {
-        return (SolanaASTNode*)parser_parse_statement(parser);
+        return parser_parse_statement(parser);
+    }
+}
+
+// What may stand outside the program's braces: the program itself and the
+// types it uses, which often follow it
+static bool solana_is_file_declaration(Parser* parser) {
+    Token* token = parser_current_token(parser);
+    return token->type == TOKEN_PROGRAM || token->type == TOKEN_STATE ||
+           token->type == TOKEN_EVENT || token->type == TOKEN_ERROR ||
+           (token->type == TOKEN_IDENTIFIER && token_equals(parser->source, token, "enum"));
+}
+
+// File-level recovery: skips to the next declaration that may stand at the
+// top, stepping over whole blocks so their contents are not taken for one
+static void solana_synchronize_file(Parser* parser) {
+    parser->panicking = false;
+    int depth = 0;
+    
+    for (;;) {
+        TokenType type = parser_current_token(parser)->type;
+        if (type == TOKEN_EOF || (depth == 0 && solana_is_file_declaration(parser))) return;
+        
+        if (type == TOKEN_LBRACE) depth++;
+        if (type == TOKEN_RBRACE && depth > 0) depth--;
+        parser_advance(parser);
     }
 }
 
+// A whole source file as one NODE_PROGRAM list of its top-level
+// declarations. Comments and blank lines may come before any of them
+ASTNode* solana_parser_parse_file(Parser* parser) {
+    ASTNode* file = ast_create_list_node(parser->arena, NODE_PROGRAM);
+    int file_start = parser_current_token(parser)->start;
+    int programs = 0;
+    
+    // Keep going past errors so one run reports all of them, up to the limit
+    while (!diag_limit_reached() && parser_current_token(parser)->type != TOKEN_EOF) {
+        if (parser_match(parser, TOKEN_NEWLINE)) continue;
+        
+        if (!solana_is_file_declaration(parser)) {
+            parser_error(parser, DIAG_UNEXPECTED_TOKEN, parser_current_token(parser),
+                         "Expected a program, state, event, enum or error declaration");
+        } else {
+            ASTNode* decl = solana_parser_parse(parser);
+            if (decl->type == NODE_PROGRAM_DECL && programs++ > 0) {
+                diag_report(DIAG_UNEXPECTED_TOKEN, decl->span.start, decl->span.length,
+                            "A file holds one program");
+            } else {
+                ast_list_append(parser->arena, file, decl);
+            }
+        }
+        
+        if (parser->panicking) solana_synchronize_file(parser);
+    }
+    
+    if (programs == 0 && !diag_limit_reached()) {
+        Token* end = parser_current_token(parser);
+        diag_report(DIAG_EXPECTED_TOKEN, end->start, 0, "Expected a program declaration");
+    }
+    
+    solana_link_layouts(parser->arena, file);
+    parser_span(parser, file, file_start);
+    return file;
+}
+
 // ============================================================================
 // SOLANA COMPILER
 // ============================================================================
 
+// Constant boilerplate, emitted with one copy each
+static const char anchor_imports[] =
+    "use anchor_lang::prelude::*;\n"
+    "use anchor_spl::token::{self, Token, TokenAccount, Mint};\n"
+    "use anchor_spl::associated_token::AssociatedToken;\n"
+    "\n";
+
+static const char native_imports[] =
+    "use solana_program::{\n"
+    "    account_info::{next_account_info, AccountInfo},\n"
+    "    entrypoint,\n"
+    "    entrypoint::ProgramResult,\n"
+    "    msg,\n"
+    "    program_error::ProgramError,\n"
+    "    pubkey::Pubkey,\n"
+    "    system_instruction,\n"
+    "    program::{invoke, invoke_signed},\n"
+    "};\n"
+    "use borsh::{BorshDeserialize, BorshSerialize};\n"
+    "\n";
+
+static const char native_entrypoint[] =
+    "entrypoint!(process_instruction);\n\n";
+
+static const char native_process_instruction[] =
+    "pub fn process_instruction(\n"
+    "    program_id: &Pubkey,\n"
+    "    accounts: &[AccountInfo],\n"
+    "    instruction_data: &[u8],\n"
+    ") -> ProgramResult {\n";
+
+static const char anchor_error_types[] =
+    "#[error_code]\n"
+    "pub enum ErrorCode {\n"
+    "    #[msg(\"Custom error message\")]\n"
+    "    CustomError,\n"
+    "}\n\n";
+
+static const char anchor_transfer[] =
+    "        token::transfer(\n"
+    "            CpiContext::new(\n"
+    "                ctx.accounts.token_program.to_account_info(),\n"
+    "                token::Transfer {\n"
+    "                    from: ctx.accounts.from.to_account_info(),\n"
+    "                    to: ctx.accounts.to.to_account_info(),\n"
+    "                    authority: ctx.accounts.authority.to_account_info(),\n"
+    "                },\n"
+    "            ),\n"
+    "            amount,\n"
+    "        )?;\n";
+
+static const char native_transfer[] =
+    "            let instruction = system_instruction::transfer(\n"
+    "                from.key,\n"
+    "                to.key,\n"
+    "                amount,\n"
+    "            );\n"
+    "            invoke(&instruction, &[from.clone(), to.clone()])?;\n";
+
+// Snippets around one declared name
+static Template anchor_program_module = TEMPLATE(
+    "#[program]\n"
+    "pub mod {{name}} {\n"
+    "    use super::*;\n\n");
+
+static Template anchor_declare_id = TEMPLATE("    declare_id!(\"{{id}}\");\n\n");
+static Template native_declare_id = TEMPLATE("declare_id!(\"{{id}}\");\n\n");
+
+static Template anchor_handler = TEMPLATE("    pub fn {{name}}(ctx: Context<{{name}}Context>");
+static Template native_handler_message = TEMPLATE(" => {\n            msg!(\"Executing {{name}}\");\n");
+
+static Template native_next_account = TEMPLATE("            let {{name}} = next_account_info(accounts_iter)?;\n");
+
+// Scalars follow the instruction's tag byte, Borsh-encoded in declaration order
+static const char native_args_cursor[] =
+    "            let mut instruction_args = &instruction_data[1..];\n";
+
+static const char native_read_arg[] =
+    " = BorshDeserialize::deserialize(&mut instruction_args)\n"
+    "                .map_err(|_| ProgramError::InvalidInstructionData)?;\n";
+
+static Template native_signer_check = TEMPLATE(
+    "            if !{{name}}.is_signer {\n"
+    "                return Err(ProgramError::MissingRequiredSignature);\n"
+    "            }\n");
+
+static Template native_writable_check = TEMPLATE(
+    "            if !{{name}}.is_writable {\n"
+    "                return Err(ProgramError::InvalidAccountData);\n"
+    "            }\n");
+
+static Template anchor_accounts_struct = TEMPLATE(
+    "#[derive(Accounts)]\n"
+    "pub struct {{name}}Context<'info> {\n");
+
+static Template struct_header = TEMPLATE("pub struct {{name}} {\n");
+static Template enum_header = TEMPLATE("pub enum {{name}} {\n");
+static Template state_len = TEMPLATE("}\n\nimpl {{name}} {\n    pub const LEN: usize = ");
+
+static Template native_error_conversion = TEMPLATE(
+    "impl From<{{name}}> for ProgramError {\n"
+    "    fn from(error: {{name}}) -> Self {\n"
+    "        ProgramError::Custom(error as u32)\n"
+    "    }\n"
+    "}\n\n");
+
 SolanaCompiler* solana_compiler_create(FILE* output, bool use_anchor) {
     SolanaCompiler* compiler = malloc(sizeof(SolanaCompiler));
-    compiler->output = output;
+    emitter_init(&compiler->core.out, output);
+    compiler->core.to_rust = true;
     compiler->use_anchor = use_anchor;
     compiler->native_solana = !use_anchor;
     compiler->program_name = NULL;
@@ -399,257 +980,555 @@ SolanaCompiler* solana_compiler_create(FILE* output, bool use_anchor) {
 }
 
 void emit_anchor_imports(SolanaCompiler* compiler) {
-    fprintf(compiler->output, "use anchor_lang::prelude::*;\n");
-    fprintf(compiler->output, "use anchor_spl::token::{self, Token, TokenAccount, Mint};\n");
-    fprintf(compiler->output, "use anchor_spl::associated_token::AssociatedToken;\n");
-    fprintf(compiler->output, "\n");
+    emit_literal(&compiler->core.out, anchor_imports);
 }
 
 void emit_native_solana_imports(SolanaCompiler* compiler) {
-    fprintf(compiler->output, "use solana_program::{\n");
-    fprintf(compiler->output, "    account_info::{next_account_info, AccountInfo},\n");
-    fprintf(compiler->output, "    entrypoint,\n");
-    fprintf(compiler->output, "    entrypoint::ProgramResult,\n");
-    fprintf(compiler->output, "    msg,\n");
-    fprintf(compiler->output, "    program_error::ProgramError,\n");
-    fprintf(compiler->output, "    pubkey::Pubkey,\n");
-    fprintf(compiler->output, "    system_instruction,\n");
-    fprintf(compiler->output, "    program::{invoke, invoke_signed},\n");
-    fprintf(compiler->output, "};\n");
-    fprintf(compiler->output, "\n");
-}
-
-void emit_program_structure(SolanaCompiler* compiler, SolanaASTNode* program) {
+    emit_literal(&compiler->core.out, native_imports);
+}
+
+void emit_program_structure(SolanaCompiler* compiler, ASTNode* program) {
     if (compiler->use_anchor) {
-        fprintf(compiler->output, "#[program]\n");
-        fprintf(compiler->output, "pub mod %s {\n", program->value);
-        fprintf(compiler->output, "    use super::*;\n\n");
+        emit_template(&compiler->core.out, &anchor_program_module, &program->value);
         
-        if (program->program_id) {
-            fprintf(compiler->output, "    declare_id!(\"%s\");\n\n", program->program_id);
+        if (program->as.list.program_id != SYMBOL_NONE) {
+            emit_template(&compiler->core.out, &anchor_declare_id, &program->as.list.program_id);
         }
     } else {
-        fprintf(compiler->output, "entrypoint!(process_instruction);\n\n");
+        emit_literal(&compiler->core.out, native_entrypoint);
         
-        if (program->program_id) {
-            fprintf(compiler->output, "declare_id!(\"%s\");\n\n", program->program_id);
+        if (program->as.list.program_id != SYMBOL_NONE) {
+            emit_template(&compiler->core.out, &native_declare_id, &program->as.list.program_id);
         }
         
-        fprintf(compiler->output, "pub fn process_instruction(\n");
-        fprintf(compiler->output, "    program_id: &Pubkey,\n");
-        fprintf(compiler->output, "    accounts: &[AccountInfo],\n");
-        fprintf(compiler->output, "    instruction_data: &[u8],\n");
-        fprintf(compiler->output, ") -> ProgramResult {\n");
+        emit_literal(&compiler->core.out, native_process_instruction);
     }
 }
 
-void emit_instruction_handler(SolanaCompiler* compiler, SolanaASTNode* instruction) {
+// Rust spelling of a parameter or field type: built-ins map, named types are kept
+static const char* solana_rust_type(uint8_t solana_type, Symbol type_name) {
+    if (solana_type == SOLANA_TYPE_DEFINED) return symbol_text(type_name);
+    return solana_types[solana_type].rust;
+}
+
+static const InstructionParam* param_table_find(const ParamTable* params, Symbol name) {
+    if (!params) return NULL;
+    for (int i = 0; i < params->count; i++) {
+        if (params->items[i].name == name) return &params->items[i];
+    }
+    return NULL;
+}
+
+// One seed as a byte slice: string literals become byte strings, accounts
+// and `x.key` their key, scalar arguments their little-endian bytes
+static void emit_seed(SolanaCompiler* compiler, ASTNode* seed, const ParamTable* params) {
+    if (seed->type == NODE_STRING) {
+        emit_str(&compiler->core.out, "b\"");
+        emit_sym(&compiler->core.out, seed->value);
+        emit_char(&compiler->core.out, '"');
+        return;
+    }
+    
+    if (seed->type == NODE_MEMBER_ACCESS && seed->as.operand->type == NODE_IDENTIFIER &&
+        strcmp(symbol_text(seed->value), "key") == 0) {
+        emit_sym(&compiler->core.out, seed->as.operand->value);
+        emit_str(&compiler->core.out, ".key().as_ref()");
+        return;
+    }
+    
+    if (seed->type == NODE_IDENTIFIER) {
+        const InstructionParam* param = param_table_find(params, seed->value);
+        if (param && param->is_account) {
+            emit_sym(&compiler->core.out, seed->value);
+            emit_str(&compiler->core.out, ".key().as_ref()");
+            return;
+        }
+        if (param && param->solana_type != SOLANA_TYPE_STRING && param->solana_type != SOLANA_TYPE_BYTES &&
+            param->solana_type != SOLANA_TYPE_PUBKEY && param->solana_type != SOLANA_TYPE_DEFINED) {
+            emit_sym(&compiler->core.out, seed->value);
+            emit_str(&compiler->core.out, ".to_le_bytes().as_ref()");
+            return;
+        }
+    }
+    
+    compiler_emit_node(&compiler->core, seed);
+    emit_str(&compiler->core.out, ".as_ref()");
+}
+
+// The `#[account(...)]` attribute for one account
+static void emit_account_constraints(SolanaCompiler* compiler, const InstructionParam* account,
+                                     const ParamTable* params) {
+    const AccountConstraint* constraint = &account->constraint;
+    const char* separator = "";
+    emit_str(&compiler->core.out, "    #[account(");
+    
+    if (constraint->is_init) {
+        emit_str(&compiler->core.out, "init, payer = ");
+        emit_sym(&compiler->core.out, constraint->payer);
+        emit_str(&compiler->core.out, ", space = ");
+        // The discriminator plus the state's layout; external types get a guess
+        if (constraint->space) {
+            compiler_emit_node(&compiler->core, constraint->space);
+        } else if (account->layout) {
+            emit_str(&compiler->core.out, "8 + ");
+            emit_int(&compiler->core.out, account->layout->size);
+        } else {
+            emit_str(&compiler->core.out, "8 + 32");
+        }
+        separator = ", ";
+    } else if (constraint->is_writable) {
+        emit_str(&compiler->core.out, "mut");
+        separator = ", ";
+    }
+    
+    if (constraint->is_signer) {
+        emit_str(&compiler->core.out, separator);
+        emit_str(&compiler->core.out, "signer");
+        separator = ", ";
+    }
+    
+    if (constraint->seed_count) {
+        emit_str(&compiler->core.out, separator);
+        emit_str(&compiler->core.out, "seeds = [");
+        for (int i = 0; i < constraint->seed_count; i++) {
+            if (i > 0) emit_str(&compiler->core.out, ", ");
+            emit_seed(compiler, constraint->seeds[i], params);
+        }
+        emit_char(&compiler->core.out, ']');
+        separator = ", ";
+    }
+    
+    if (constraint->has_bump) {
+        emit_str(&compiler->core.out, separator);
+        emit_str(&compiler->core.out, "bump");
+        separator = ", ";
+    }
+    
+    if (constraint->token_mint != SYMBOL_NONE) {
+        emit_str(&compiler->core.out, separator);
+        emit_str(&compiler->core.out, "token::mint = ");
+        emit_sym(&compiler->core.out, constraint->token_mint);
+        separator = ", ";
+    }
+    
+    if (constraint->token_authority != SYMBOL_NONE) {
+        emit_str(&compiler->core.out, separator);
+        emit_str(&compiler->core.out, "token::authority = ");
+        emit_sym(&compiler->core.out, constraint->token_authority);
+    }
+    
+    emit_str(&compiler->core.out, ")]\n");
+}
+
+static void emit_account_field(SolanaCompiler* compiler, Symbol name, uint8_t solana_type, Symbol type_name) {
+    if (solana_type == SOLANA_TYPE_DEFINED) {
+        emit_str(&compiler->core.out, "    pub ");
+        emit_sym(&compiler->core.out, name);
+        emit_str(&compiler->core.out, ": Account<'info, ");
+        emit_sym(&compiler->core.out, type_name);
+        emit_str(&compiler->core.out, ">,\n");
+    } else {
+        emit_str(&compiler->core.out, "    /// CHECK: unchecked account\n");
+        emit_str(&compiler->core.out, "    pub ");
+        emit_sym(&compiler->core.out, name);
+        emit_str(&compiler->core.out, ": AccountInfo<'info>,\n");
+    }
+}
+
+static void solana_compile_node(SolanaCompiler* compiler, ASTNode* ast);
+
+static void emit_instruction_handler(void* context, ASTNode* instruction) {
+    SolanaCompiler* compiler = context;
+    const ParamTable* params = instruction->as.instruction.params;
+    ASTNode* body = instruction->as.instruction.body;
+    
     if (compiler->use_anchor) {
-        fprintf(compiler->output, "    pub fn %s(ctx: Context<%sContext>) -> Result<()> {\n", 
-                instruction->instruction_name, instruction->instruction_name);
+        emit_template(&compiler->core.out, &anchor_handler, &instruction->value);
         
-        if (instruction->left) {
-            fprintf(compiler->output, "        // Generated instruction logic\n");
-            solana_compiler_compile(compiler, instruction->left);
+        // Accounts travel in the context; only scalars are arguments
+        for (int i = 0; params && i < params->count; i++) {
+            const InstructionParam* param = &params->items[i];
+            if (param->is_account) continue;
+            emit_str(&compiler->core.out, ", ");
+            emit_sym(&compiler->core.out, param->name);
+            emit_str(&compiler->core.out, ": ");
+            emit_str(&compiler->core.out, solana_rust_type(param->solana_type, param->type_name));
         }
+        emit_str(&compiler->core.out, ") -> Result<()> {\n");
         
-        fprintf(compiler->output, "        Ok(())\n");
-        fprintf(compiler->output, "    }\n\n");
+        if (body && body->as.list.count) {
+            emit_str(&compiler->core.out, "        // Generated instruction logic\n");
+            for (int i = 0; i < body->as.list.count; i++) {
+                solana_compile_node(compiler, body->as.list.items[i]);
+            }
+        }
+        
+        emit_str(&compiler->core.out, "        Ok(())\n");
+        emit_str(&compiler->core.out, "    }\n\n");
     } else {
-        fprintf(compiler->output, "    match instruction_data[0] {\n");
-        fprintf(compiler->output, "        %d => {\n", compiler->instruction_count);
-        fprintf(compiler->output, "            msg!(\"Executing %s\");\n", instruction->instruction_name);
+        emit_str(&compiler->core.out, "    match instruction_data[0] {\n");
+        emit_str(&compiler->core.out, "        ");
+        emit_int(&compiler->core.out, compiler->instruction_count);
+        emit_template(&compiler->core.out, &native_handler_message, &instruction->value);
         
-        if (instruction->left) {
-            solana_compiler_compile(compiler, instruction->left);
+        // Accounts arrive in declaration order; their constraints are checked by hand
+        if (params && params->account_count) {
+            emit_str(&compiler->core.out, "            let accounts_iter = &mut accounts.iter();\n");
+        }
+        for (int i = 0; params && i < params->count; i++) {
+            const InstructionParam* param = &params->items[i];
+            if (!param->is_account) continue;
+            
+            emit_template(&compiler->core.out, &native_next_account, &param->name);
+            if (param->constraint.is_signer) {
+                emit_template(&compiler->core.out, &native_signer_check, &param->name);
+            }
+            if (param->constraint.is_writable || param->constraint.is_init) {
+                emit_template(&compiler->core.out, &native_writable_check, &param->name);
+            }
         }
         
-        fprintf(compiler->output, "        },\n");
-        fprintf(compiler->output, "    }\n");
+        if (params && params->count > params->account_count) {
+            emit_literal(&compiler->core.out, native_args_cursor);
+        }
+        for (int i = 0; params && i < params->count; i++) {
+            const InstructionParam* param = &params->items[i];
+            if (param->is_account) continue;
+            
+            emit_str(&compiler->core.out, "            let ");
+            emit_sym(&compiler->core.out, param->name);
+            emit_str(&compiler->core.out, ": ");
+            emit_str(&compiler->core.out, solana_rust_type(param->solana_type, param->type_name));
+            emit_literal(&compiler->core.out, native_read_arg);
+        }
+        
+        for (int i = 0; body && i < body->as.list.count; i++) {
+            solana_compile_node(compiler, body->as.list.items[i]);
+        }
+        
+        emit_str(&compiler->core.out, "        },\n");
+        emit_str(&compiler->core.out, "    }\n");
     }
     
     compiler->instruction_count++;
 }
 
-void emit_account_validation(SolanaCompiler* compiler, SolanaASTNode* accounts) {
-    if (compiler->use_anchor) {
-        fprintf(compiler->output, "#[derive(Accounts)]\n");
-        fprintf(compiler->output, "pub struct %sContext<'info> {\n", accounts->instruction_name);
+// The Anchor `Accounts` struct behind an instruction's Context, one field
+// per `@account` parameter in declaration order
+void emit_instruction_accounts(SolanaCompiler* compiler, ASTNode* instruction) {
+    const ParamTable* params = instruction->as.instruction.params;
+    bool needs_system_program = false;
+    bool has_system_program = false;
+    
+    emit_template(&compiler->core.out, &anchor_accounts_struct, &instruction->value);
+    
+    for (int i = 0; params && i < params->count; i++) {
+        const InstructionParam* param = &params->items[i];
+        if (!param->is_account) continue;
         
-        for (int i = 0; i < accounts->child_count; i++) {
-            SolanaASTNode* account = (SolanaASTNode*)accounts->children[i];
-            fprintf(compiler->output, "    #[account(");
-            
-            if (account->is_signer) fprintf(compiler->output, "signer, ");
-            if (account->is_writable) fprintf(compiler->output, "mut, ");
-            if (account->is_init) fprintf(compiler->output, "init, payer = payer, space = 8 + 32, ");
-            
-            fprintf(compiler->output, ")]\n");
-            fprintf(compiler->output, "    pub %s: Account<'info, ", account->account_name);
-            
-            switch (account->solana_type) {
-                case SOLANA_TYPE_PUBKEY:
-                    fprintf(compiler->output, "Pubkey");
-                    break;
-                case SOLANA_TYPE_ACCOUNT_INFO:
-                    fprintf(compiler->output, "AccountInfo");
-                    break;
-                default:
-                    fprintf(compiler->output, "AccountInfo");
-                    break;
-            }
-            
-            fprintf(compiler->output, ">,\n");
+        const AccountConstraint* constraint = &param->constraint;
+        if (constraint->is_init) needs_system_program = true;
+        if (strcmp(symbol_text(param->name), "system_program") == 0) has_system_program = true;
+        
+        if (constraint->is_init || constraint->is_writable || constraint->seed_count ||
+            constraint->token_mint != SYMBOL_NONE || constraint->token_authority != SYMBOL_NONE) {
+            emit_account_constraints(compiler, param, params);
         }
         
-        fprintf(compiler->output, "}\n\n");
+        if (constraint->is_signer && param->solana_type != SOLANA_TYPE_DEFINED) {
+            emit_str(&compiler->core.out, "    pub ");
+            emit_sym(&compiler->core.out, param->name);
+            emit_str(&compiler->core.out, ": Signer<'info>,\n");
+        } else {
+            emit_account_field(compiler, param->name, param->solana_type, param->type_name);
+        }
     }
+    
+    // `init` creates the account through the system program
+    if (needs_system_program && !has_system_program) {
+        emit_str(&compiler->core.out, "    pub system_program: Program<'info, System>,\n");
+    }
+    
+    emit_str(&compiler->core.out, "}\n\n");
 }
 
-void emit_state_structure(SolanaCompiler* compiler, SolanaASTNode* state) {
+static void emit_account_validation(void* context, ASTNode* account) {
+    SolanaCompiler* compiler = context;
     if (compiler->use_anchor) {
-        fprintf(compiler->output, "#[account]\n");
+        emit_template(&compiler->core.out, &anchor_accounts_struct, &account->value);
+        const InstructionParam* declared = account->as.account;
+        emit_account_constraints(compiler, declared, NULL);
+        emit_account_field(compiler, declared->name, declared->solana_type, declared->type_name);
+        emit_str(&compiler->core.out, "}\n\n");
     }
+}
+
+static void emit_type_fields(SolanaCompiler* compiler, const TypeLayout* layout) {
+    for (int i = 0; i < layout->field_count; i++) {
+        const TypeField* field = &layout->fields[i];
+        emit_str(&compiler->core.out, "    pub ");
+        emit_sym(&compiler->core.out, field->name);
+        emit_str(&compiler->core.out, ": ");
+        emit_str(&compiler->core.out, solana_rust_type(field->solana_type, field->type_name));
+        emit_str(&compiler->core.out, ",\n");
+    }
+}
+
+// LEN is the serialized size from the layout; account space is built on it
+static void emit_state_structure(void* context, ASTNode* state) {
+    SolanaCompiler* compiler = context;
+    const TypeLayout* layout = state->as.layout;
     
-    fprintf(compiler->output, "#[derive(Clone, Debug, PartialEq)]\n");
-    fprintf(compiler->output, "pub struct %s {\n", state->value);
+    if (compiler->use_anchor) {
+        emit_str(&compiler->core.out, "#[account]\n");
+        emit_str(&compiler->core.out, "#[derive(Debug, PartialEq)]\n");
+    } else {
+        emit_str(&compiler->core.out, "#[derive(BorshSerialize, BorshDeserialize, Clone, Debug, PartialEq)]\n");
+    }
     
-    for (int i = 0; i < state->child_count; i++) {
-        SolanaASTNode* field = (SolanaASTNode*)state->children[i];
-        fprintf(compiler->output, "    pub %s: ", field->value);
-        
-        switch (field->solana_type) {
-            case SOLANA_TYPE_PUBKEY:
-                fprintf(compiler->output, "Pubkey");
-                break;
-            case SOLANA_TYPE_U64:
-                fprintf(compiler->output, "u64");
-                break;
-            case SOLANA_TYPE_U32:
-                fprintf(compiler->output, "u32");
-                break;
-            case SOLANA_TYPE_BOOL:
-                fprintf(compiler->output, "bool");
-                break;
-            case SOLANA_TYPE_STRING:
-                fprintf(compiler->output, "String");
-                break;
-            default:
-                fprintf(compiler->output, "u64");
-                break;
+    emit_template(&compiler->core.out, &struct_header, &layout->name);
+    emit_type_fields(compiler, layout);
+    emit_template(&compiler->core.out, &state_len, &layout->name);
+    emit_int(&compiler->core.out, layout->size);
+    emit_str(&compiler->core.out, ";\n");
+    emit_str(&compiler->core.out, "}\n\n");
+}
+
+static void emit_event_structure(void* context, ASTNode* event) {
+    SolanaCompiler* compiler = context;
+    const TypeLayout* layout = event->as.layout;
+    
+    if (compiler->use_anchor) {
+        emit_str(&compiler->core.out, "#[event]\n");
+    } else {
+        emit_str(&compiler->core.out, "#[derive(BorshSerialize, BorshDeserialize, Debug)]\n");
+    }
+    
+    emit_template(&compiler->core.out, &struct_header, &layout->name);
+    emit_type_fields(compiler, layout);
+    emit_str(&compiler->core.out, "}\n\n");
+}
+
+static void emit_enum_type(void* context, ASTNode* decl) {
+    SolanaCompiler* compiler = context;
+    const TypeLayout* layout = decl->as.layout;
+    
+    if (compiler->use_anchor) {
+        emit_str(&compiler->core.out, "#[derive(AnchorSerialize, AnchorDeserialize, Clone, Copy, Debug, PartialEq, Eq)]\n");
+    } else {
+        emit_str(&compiler->core.out, "#[derive(BorshSerialize, BorshDeserialize, Clone, Copy, Debug, PartialEq, Eq)]\n");
+    }
+    
+    emit_template(&compiler->core.out, &enum_header, &layout->name);
+    for (int i = 0; i < layout->field_count; i++) {
+        emit_indent(&compiler->core.out, 1);
+        emit_sym(&compiler->core.out, layout->fields[i].name);
+        emit_str(&compiler->core.out, ",\n");
+    }
+    emit_str(&compiler->core.out, "}\n\n");
+}
+
+// A declared error enum; native programs surface it as a custom error code
+static void emit_error_enum(void* context, ASTNode* decl) {
+    SolanaCompiler* compiler = context;
+    const TypeLayout* layout = decl->as.layout;
+    
+    if (compiler->use_anchor) {
+        emit_str(&compiler->core.out, "#[error_code]\n");
+        emit_template(&compiler->core.out, &enum_header, &layout->name);
+        for (int i = 0; i < layout->field_count; i++) {
+            const TypeField* variant = &layout->fields[i];
+            if (variant->type_name != SYMBOL_NONE) {
+                emit_str(&compiler->core.out, "    #[msg(\"");
+                emit_sym(&compiler->core.out, variant->type_name);
+                emit_str(&compiler->core.out, "\")]\n");
+            }
+            emit_indent(&compiler->core.out, 1);
+            emit_sym(&compiler->core.out, variant->name);
+            emit_str(&compiler->core.out, ",\n");
         }
-        
-        fprintf(compiler->output, ",\n");
+        emit_str(&compiler->core.out, "}\n\n");
+        return;
     }
     
-    fprintf(compiler->output, "}\n\n");
+    emit_str(&compiler->core.out, "#[derive(Clone, Copy, Debug, PartialEq, Eq)]\n");
+    emit_template(&compiler->core.out, &enum_header, &layout->name);
+    for (int i = 0; i < layout->field_count; i++) {
+        emit_indent(&compiler->core.out, 1);
+        emit_sym(&compiler->core.out, layout->fields[i].name);
+        emit_str(&compiler->core.out, " = ");
+        emit_int(&compiler->core.out, i);
+        emit_str(&compiler->core.out, ",\n");
+    }
+    emit_str(&compiler->core.out, "}\n\n");
+    
+    emit_template(&compiler->core.out, &native_error_conversion, &layout->name);
 }
 
 void emit_error_types(SolanaCompiler* compiler) {
     if (compiler->use_anchor) {
-        fprintf(compiler->output, "#[error_code]\n");
-        fprintf(compiler->output, "pub enum ErrorCode {\n");
-        fprintf(compiler->output, "    #[msg(\"Custom error message\")]\n");
-        fprintf(compiler->output, "    CustomError,\n");
-        fprintf(compiler->output, "}\n\n");
+        emit_literal(&compiler->core.out, anchor_error_types);
     }
 }
 
-void solana_compiler_compile(SolanaCompiler* compiler, SolanaASTNode* ast) {
-    if (!ast) return;
+static void emit_program(void* context, ASTNode* program) {
+    SolanaCompiler* compiler = context;
     
-    switch (ast->type) {
-        case NODE_PROGRAM_DECL:
-            if (compiler->use_anchor) {
-                emit_anchor_imports(compiler);
-            } else {
-                emit_native_solana_imports(compiler);
-            }
-            
-            emit_program_structure(compiler, ast);
-            
-            for (int i = 0; i < ast->child_count; i++) {
-                solana_compiler_compile(compiler, (SolanaASTNode*)ast->children[i]);
-            }
-            
-            if (compiler->use_anchor) {
-                fprintf(compiler->output, "}\n"); // Close program module
-            } else {
-                fprintf(compiler->output, "    Ok(())\n");
-                fprintf(compiler->output, "}\n"); // Close process_instruction
-            }
-            break;
-            
-        case NODE_INSTRUCTION_DECL:
-            emit_instruction_handler(compiler, ast);
-            break;
-            
-        case NODE_ACCOUNT_DECL:
-            emit_account_validation(compiler, ast);
-            break;
-            
-        case NODE_STATE_DECL:
-            emit_state_structure(compiler, ast);
-            break;
-            
-        case NODE_TRANSFER_STMT:
-            if (compiler->use_anchor) {
-                fprintf(compiler->output, "        token::transfer(\n");
-                fprintf(compiler->output, "            CpiContext::new(\n");
-                fprintf(compiler->output, "                ctx.accounts.token_program.to_account_info(),\n");
-                fprintf(compiler->output, "                token::Transfer {\n");
-                fprintf(compiler->output, "                    from: ctx.accounts.from.to_account_info(),\n");
-                fprintf(compiler->output, "                    to: ctx.accounts.to.to_account_info(),\n");
-                fprintf(compiler->output, "                    authority: ctx.accounts.authority.to_account_info(),\n");
-                fprintf(compiler->output, "                },\n");
-                fprintf(compiler->output, "            ),\n");
-                fprintf(compiler->output, "            amount,\n");
-                fprintf(compiler->output, "        )?;\n");
-            } else {
-                fprintf(compiler->output, "            let instruction = system_instruction::transfer(\n");
-                fprintf(compiler->output, "                from.key,\n");
-                fprintf(compiler->output, "                to.key,\n");
-                fprintf(compiler->output, "                amount,\n");
-                fprintf(compiler->output, "            );\n");
-                fprintf(compiler->output, "            invoke(&instruction, &[from.clone(), to.clone()])?;\n");
-            }
-            break;
-            
-        case NODE_REQUIRE_STMT:
-            if (compiler->use_anchor) {
-                fprintf(compiler->output, "        require!(");
-                if (ast->condition) {
-                    solana_compiler_compile(compiler, ast->condition);
-                }
-                fprintf(compiler->output, ", ErrorCode::CustomError);\n");
-            } else {
-                fprintf(compiler->output, "            if !(");
-                if (ast->condition) {
-                    solana_compiler_compile(compiler, ast->condition);
-                }
-                fprintf(compiler->output, ") {\n");
-                fprintf(compiler->output, "                return Err(ProgramError::InvalidArgument);\n");
-                fprintf(compiler->output, "            }\n");
-            }
-            break;
-            
-        case NODE_PRINT_STMT:
-            fprintf(compiler->output, "        msg!(\"");
-            if (ast->left) {
-                fprintf(compiler->output, "Debug: {}\"");
+    if (compiler->use_anchor) {
+        emit_anchor_imports(compiler);
+    } else {
+        emit_native_solana_imports(compiler);
+    }
+    
+    emit_program_structure(compiler, program);
+    
+    // Type declarations are items of their own, after the program body
+    for (int i = 0; i < program->as.list.count; i++) {
+        if (solana_is_type_declaration(program->as.list.items[i])) continue;
+        solana_compile_node(compiler, program->as.list.items[i]);
+    }
+    
+    if (compiler->use_anchor) {
+        emit_str(&compiler->core.out, "}\n\n"); // Close program module
+        
+        for (int i = 0; i < program->as.list.count; i++) {
+            if (program->as.list.items[i]->type == NODE_INSTRUCTION_DECL) {
+                emit_instruction_accounts(compiler, program->as.list.items[i]);
             }
-            fprintf(compiler->output, ");\n");
-            break;
-            
-        default:
-            compiler_compile_node((Compiler*)compiler, (ASTNode*)ast);
-            break;
+        }
+    } else {
+        emit_str(&compiler->core.out, "    Ok(())\n");
+        emit_str(&compiler->core.out, "}\n\n"); // Close process_instruction
+    }
+    
+    for (int i = 0; i < program->as.list.count; i++) {
+        if (solana_is_type_declaration(program->as.list.items[i])) {
+            solana_compile_node(compiler, program->as.list.items[i]);
+        }
+    }
+}
+
+static void emit_transfer(void* context, ASTNode* transfer) {
+    SolanaCompiler* compiler = context;
+    (void)transfer;
+    
+    if (compiler->use_anchor) {
+        emit_literal(&compiler->core.out, anchor_transfer);
+    } else {
+        emit_literal(&compiler->core.out, native_transfer);
     }
 }
 
+// `Enum.Variant` names a declared error; Rust spells the path with '::'
+static void emit_error_value(SolanaCompiler* compiler, ASTNode* error) {
+    if (error->type == NODE_MEMBER_ACCESS && error->as.operand->type == NODE_IDENTIFIER) {
+        emit_sym(&compiler->core.out, error->as.operand->value);
+        emit_str(&compiler->core.out, "::");
+        emit_sym(&compiler->core.out, error->value);
+    } else {
+        solana_compile_node(compiler, error);
+    }
+}
+
+static void emit_require(void* context, ASTNode* require_stmt) {
+    SolanaCompiler* compiler = context;
+    ASTNode* error = require_stmt->as.binary.right;
+    
+    if (compiler->use_anchor) {
+        emit_str(&compiler->core.out, "        require!(");
+        solana_compile_node(compiler, require_stmt->as.binary.left);
+        emit_str(&compiler->core.out, ", ");
+        if (error) {
+            emit_error_value(compiler, error);
+        } else {
+            emit_str(&compiler->core.out, "ErrorCode::CustomError");
+        }
+        emit_str(&compiler->core.out, ");\n");
+    } else {
+        emit_str(&compiler->core.out, "            if !(");
+        solana_compile_node(compiler, require_stmt->as.binary.left);
+        emit_str(&compiler->core.out, ") {\n");
+        if (error) {
+            emit_str(&compiler->core.out, "                return Err(");
+            emit_error_value(compiler, error);
+            emit_str(&compiler->core.out, ".into());\n");
+        } else {
+            emit_str(&compiler->core.out, "                return Err(ProgramError::InvalidArgument);\n");
+        }
+        emit_str(&compiler->core.out, "            }\n");
+    }
+}
+
+static void emit_print(void* context, ASTNode* print_stmt) {
+    SolanaCompiler* compiler = context;
+    
+    emit_str(&compiler->core.out, "        msg!(\"");
+    if (print_stmt->as.operand) {
+        emit_str(&compiler->core.out, "Debug: {}\"");
+    }
+    emit_str(&compiler->core.out, ");\n");
+}
+
+// Statements and expressions of the core language, as Rust
+static void emit_core(void* context, ASTNode* node) {
+    SolanaCompiler* compiler = context;
+    compiler_emit_node(&compiler->core, node);
+}
+
+static const Backend solana_backend = {
+    "solana",
+    {
+        [NODE_PROGRAM]          = emit_core,
+        [NODE_VAR_DECL]         = emit_core,
+        [NODE_FUNC_DECL]        = emit_core,
+        [NODE_PARAM]            = emit_core,
+        [NODE_IF_STMT]          = emit_core,
+        [NODE_RETURN_STMT]      = emit_core,
+        [NODE_PRINT_STMT]       = emit_print,
+        [NODE_BINARY_OP]        = emit_core,
+        [NODE_UNARY_OP]         = emit_core,
+        [NODE_IDENTIFIER]       = emit_core,
+        [NODE_NUMBER]           = emit_core,
+        [NODE_STRING]           = emit_core,
+        [NODE_FUNC_CALL]        = emit_core,
+        [NODE_MEMBER_ACCESS]    = emit_core,
+        [NODE_PROGRAM_DECL]     = emit_program,
+        [NODE_INSTRUCTION_DECL] = emit_instruction_handler,
+        [NODE_TRANSFER_STMT]    = emit_transfer,
+        [NODE_REQUIRE_STMT]     = emit_require,
+        [NODE_ACCOUNT_DECL]     = emit_account_validation,
+        [NODE_STATE_DECL]       = emit_state_structure,
+        [NODE_ERROR_DECL]       = emit_error_enum,
+        [NODE_EVENT_DECL]       = emit_event_structure,
+        [NODE_ENUM_DECL]        = emit_enum_type,
+    },
+};
+
+static void solana_compile_node(SolanaCompiler* compiler, ASTNode* node) {
+    if (node) backend_emit(&solana_backend, compiler, node);
+}
+
+// Takes the file from solana_parser_parse_file: the program first, then
+// the types declared after it. Everything generated is written out before
+// this returns
+bool solana_compiler_compile(SolanaCompiler* compiler, ASTNode* file) {
+    for (int i = 0; i < file->as.list.count; i++) {
+        if (file->as.list.items[i]->type == NODE_PROGRAM_DECL) {
+            solana_compile_node(compiler, file->as.list.items[i]);
+        }
+    }
+    for (int i = 0; i < file->as.list.count; i++) {
+        if (file->as.list.items[i]->type != NODE_PROGRAM_DECL) {
+            solana_compile_node(compiler, file->as.list.items[i]);
+        }
+    }
+    return emitter_flush(&compiler->core.out);
+}
+
 void solana_compiler_free(SolanaCompiler* compiler) {
     if (compiler->program_name) free(compiler->program_name);
     if (compiler->program_id) free(compiler->program_id);
+    emitter_free(&compiler->core.out);
     free(compiler);
 }
 
@@ -657,14 +1536,14 @@ void solana_compiler_free(SolanaCompiler* compiler) {
 // VALIDATION FUNCTIONS
 // ============================================================================
 
-bool validate_program_structure(SolanaASTNode* ast) {
+bool validate_program_structure(ASTNode* ast) {
     if (!ast || ast->type != NODE_PROGRAM_DECL) {
         return false;
     }
     
     bool has_instruction = false;
-    for (int i = 0; i < ast->child_count; i++) {
-        if (((SolanaASTNode*)ast->children[i])->type == NODE_INSTRUCTION_DECL) {
+    for (int i = 0; i < ast->as.list.count; i++) {
+        if (ast->as.list.items[i]->type == NODE_INSTRUCTION_DECL) {
             has_instruction = true;
             break;
         }
@@ -672,11 +1551,3 @@ bool validate_program_structure(SolanaASTNode* ast) {
     
     return has_instruction;
 }
-
-bool check_account_constraints(SolanaASTNode* accounts) {
-    return true; // Simplified for now
-}
-
-bool verify_instruction_signatures(SolanaASTNode* instructions) {
-    return true; // Simplified for now
-}
\ No newline at end of file
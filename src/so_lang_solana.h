@@ -8,64 +8,6 @@
 
 #include "so_lang.h"
 
-typedef enum {
-    // Existing tokens...
-    TOKEN_PROGRAM = 50,
-    TOKEN_INSTRUCTION,
-    TOKEN_ACCOUNT,
-    TOKEN_STATE,
-    TOKEN_PUBKEY,
-    TOKEN_LAMPORTS,
-    TOKEN_SIGNER,
-    TOKEN_WRITABLE,
-    TOKEN_INIT,
-    TOKEN_SEEDS,
-    TOKEN_BUMP,
-    TOKEN_PDA,
-    TOKEN_TRANSFER,
-    TOKEN_INVOKE,
-    TOKEN_REQUIRE,
-    TOKEN_ERROR,
-    TOKEN_EVENT,
-    TOKEN_EMIT,
-    TOKEN_ANCHOR,
-    TOKEN_SOLANA,
-    TOKEN_ENTRYPOINT,
-    TOKEN_PROCESSOR,
-    TOKEN_ACCOUNTS,
-    TOKEN_DATA,
-    TOKEN_INSTRUCTION_DATA,
-    TOKEN_SYSTEM_PROGRAM,
-    TOKEN_TOKEN_PROGRAM,
-    TOKEN_RENT,
-    TOKEN_CLOCK,
-    TOKEN_AT_SYMBOL,     // @
-    TOKEN_HASH,          // #
-    TOKEN_ARROW          // ->
-} SolanaTokenType;
-
-typedef enum {
-    NODE_PROGRAM_DECL = 200,
-    NODE_INSTRUCTION_DECL,
-    NODE_ACCOUNT_DECL,
-    NODE_STATE_DECL,
-    NODE_ACCOUNT_CONSTRAINT,
-    NODE_PDA_DERIVATION,
-    NODE_TRANSFER_STMT,
-    NODE_INVOKE_STMT,
-    NODE_REQUIRE_STMT,
-    NODE_ERROR_DECL,
-    NODE_EVENT_DECL,
-    NODE_EMIT_STMT,
-    NODE_ACCOUNT_ACCESS,
-    NODE_INSTRUCTION_HANDLER,
-    NODE_ACCOUNT_VALIDATION,
-    NODE_SOLANA_TYPE,
-    NODE_ANCHOR_ATTRIBUTE,
-    NODE_SEEDS_EXPR,
-    NODE_BUMP_EXPR
-} SolanaNodeType;
-
 typedef enum {
     CONSTRAINT_SIGNER,
     CONSTRAINT_WRITABLE,
@@ -89,36 +31,87 @@ typedef enum {
     SOLANA_TYPE_BOOL,
     SOLANA_TYPE_ACCOUNT_INFO,
     SOLANA_TYPE_INSTRUCTION,
-    SOLANA_TYPE_PROGRAM_ID
+    SOLANA_TYPE_PROGRAM_ID,
+    SOLANA_TYPE_U16,
+    SOLANA_TYPE_U128,
+    SOLANA_TYPE_I8,
+    SOLANA_TYPE_I16,
+    SOLANA_TYPE_I32,
+    SOLANA_TYPE_I64,
+    SOLANA_TYPE_I128,
+    SOLANA_TYPE_BYTES,
+    SOLANA_TYPE_DEFINED     // A state, enum or external type, by name
 } SolanaDataType;
 
-typedef struct SolanaASTNode {
-    NodeType type;
-    char value[MAX_TOKEN_LEN];
-    struct SolanaASTNode* left;
-    struct SolanaASTNode* right;
-    struct SolanaASTNode* condition;
-    struct SolanaASTNode* then_branch;
-    struct SolanaASTNode* else_branch;
-    struct SolanaASTNode** children;
-    int child_count;
-    
-    // Solana-specific fields
-    SolanaDataType solana_type;
-    ConstraintType constraint_type;
-    char* account_name;
-    char* instruction_name;
-    char* program_id;
+// Where one field sits in the Borsh encoding of its type, which is packed;
+// align is what the field would need in a zero-copy (repr(C)) view
+typedef struct {
+    Symbol name;
+    Symbol type_name;           // As written; the message of an error variant
+    uint8_t solana_type;        // SolanaDataType; unused for enum and error variants
+    int size;
+    int align;
+    int offset;
+    SourceSpan type_span;       // For errors found while sizing
+} TypeField;
+
+// A state, event, enum or error declaration with its layout. Sizes are
+// filled in once the whole program is parsed, as fields may name types
+// declared further down
+typedef struct TypeLayout {
+    Symbol name;
+    uint8_t kind;               // NODE_STATE_DECL, NODE_EVENT_DECL, NODE_ENUM_DECL or NODE_ERROR_DECL
+    uint8_t status;             // LayoutStatus
+    int size;                   // Serialized bytes, without Anchor's 8-byte discriminator
+    int align;
+    int field_count;
+    TypeField fields[];         // Fields, enum variants or error variants
+} TypeLayout;
+
+typedef enum {
+    LAYOUT_PENDING,
+    LAYOUT_SIZING,              // On the stack; seeing it again means a cycle
+    LAYOUT_DONE
+} LayoutStatus;
+
+// Everything an `@account(...)` list or an account declaration says about
+// one account, kept off the node so that only accounts pay for it
+typedef struct {
     bool is_signer;
     bool is_writable;
     bool is_init;
-    char** seeds;
+    bool has_bump;
+    Symbol payer;               // payer = x
+    Symbol token_mint;          // token::mint = x
+    Symbol token_authority;     // token::authority = x
+    ASTNode* space;             // space = expr; NULL to use the default
+    ASTNode** seeds;            // seeds = [expr, ...]
     int seed_count;
-    int bump;
-} SolanaASTNode;
+} AccountConstraint;
+
+// One instruction parameter: an `@account` with its constraints, or a
+// typed scalar passed in the instruction data
+typedef struct InstructionParam {
+    Symbol name;
+    Symbol type_name;           // As written, e.g. CounterAccount or u64
+    uint8_t solana_type;        // SolanaDataType; DEFINED for named types
+    bool is_account;
+    AccountConstraint constraint;   // Accounts only
+    const TypeLayout* layout;   // An account's state type, once the program is parsed
+} InstructionParam;
 
+// Every parameter of one instruction in declaration order, allocated at its
+// final size so emitters walk a flat array instead of the tree
+typedef struct ParamTable {
+    int count;
+    int account_count;
+    InstructionParam items[];
+} ParamTable;
+
+// Core statements inside instructions are emitted by the embedded core
+// compiler, as Rust, into the same buffer
 typedef struct {
-    FILE* output;
+    Compiler core;
     bool use_anchor;
     bool native_solana;
     char* program_name;
@@ -128,26 +121,19 @@ typedef struct {
     int state_count;
 } SolanaCompiler;
 
-SolanaASTNode* solana_ast_create_node(NodeType type);
-void solana_ast_free(SolanaASTNode* node);
-
-void solana_lexer_tokenize(Lexer* lexer);
-SolanaASTNode* solana_parser_parse(Parser* parser);
+ASTNode* solana_parser_parse(Parser* parser);
+ASTNode* solana_parser_parse_file(Parser* parser);
 
 SolanaCompiler* solana_compiler_create(FILE* output, bool use_anchor);
-void solana_compiler_compile(SolanaCompiler* compiler, SolanaASTNode* ast);
+bool solana_compiler_compile(SolanaCompiler* compiler, ASTNode* ast);
 void solana_compiler_free(SolanaCompiler* compiler);
 
 void emit_anchor_imports(SolanaCompiler* compiler);
 void emit_native_solana_imports(SolanaCompiler* compiler);
-void emit_program_structure(SolanaCompiler* compiler, SolanaASTNode* program);
-void emit_instruction_handler(SolanaCompiler* compiler, SolanaASTNode* instruction);
-void emit_account_validation(SolanaCompiler* compiler, SolanaASTNode* accounts);
-void emit_state_structure(SolanaCompiler* compiler, SolanaASTNode* state);
+void emit_program_structure(SolanaCompiler* compiler, ASTNode* program);
+void emit_instruction_accounts(SolanaCompiler* compiler, ASTNode* instruction);
 void emit_error_types(SolanaCompiler* compiler);
 
-bool validate_program_structure(SolanaASTNode* ast);
-bool check_account_constraints(SolanaASTNode* accounts);
-bool verify_instruction_signatures(SolanaASTNode* instructions);
+bool validate_program_structure(ASTNode* ast);
 
 #endif
\ No newline at end of file
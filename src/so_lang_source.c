@@ -0,0 +1,114 @@
+/*
+ * so_lang_source.c - So Lang Source Files
+ * Reads a program into memory (mapped when it is a regular file) and
+ * compares token text against it; shared by every compiler frontend
+ */
+
+#ifndef _DEFAULT_SOURCE
+#define _DEFAULT_SOURCE     // mmap, MAP_ANONYMOUS, fileno
+#endif
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "so_lang.h"
+
+// Regular files are mapped read-only. The mapping is backed by an anonymous
+// reservation one byte longer than the file, so the byte after the last one
+// is always a zero page byte the lexer can stop on, even when the file size
+// is an exact multiple of the page size.
+static SourceFile* read_file_mapped(int fd, size_t length) {
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    size_t mapped = (length + 1 + page - 1) & ~(page - 1);
+
+    char* base = mmap(NULL, mapped, PROT_READ, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (base == MAP_FAILED) return NULL;
+    if (mmap(base, length, PROT_READ, MAP_PRIVATE | MAP_FIXED, fd, 0) == MAP_FAILED) {
+        munmap(base, mapped);
+        return NULL;
+    }
+
+    SourceFile* file = malloc(sizeof(SourceFile));
+    file->data = base;
+    file->length = length;
+    file->mapped = mapped;
+    return file;
+}
+
+// Pipes, stdin and anything mmap refuses are read in growing chunks
+static SourceFile* read_file_streamed(FILE* stream, const char* filename) {
+    size_t capacity = 64 * 1024;
+    size_t length = 0;
+    char* content = malloc(capacity);
+
+    for (;;) {
+        if (length + 1 == capacity) {
+            capacity *= 2;
+            content = realloc(content, capacity);
+        }
+        size_t n = fread(content + length, 1, capacity - length - 1, stream);
+        length += n;
+        if (n == 0) break;
+    }
+
+    if (ferror(stream)) {
+        fprintf(stderr, "Could not read file: %s\n", filename);
+        free(content);
+        return NULL;
+    }
+    content[length] = '\0';
+
+    SourceFile* file = malloc(sizeof(SourceFile));
+    file->data = content;
+    file->length = length;
+    file->mapped = 0;
+    return file;
+}
+
+// "-" reads standard input
+SourceFile* read_file(const char* filename) {
+    if (strcmp(filename, "-") == 0) {
+        return read_file_streamed(stdin, "<stdin>");
+    }
+
+    FILE* stream = fopen(filename, "r");
+    if (!stream) {
+        fprintf(stderr, "Could not open file: %s\n", filename);
+        return NULL;
+    }
+
+    SourceFile* file = NULL;
+    struct stat st;
+    if (fstat(fileno(stream), &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+        file = read_file_mapped(fileno(stream), (size_t)st.st_size);
+    }
+    if (!file) {
+        file = read_file_streamed(stream, filename);
+    }
+
+    fclose(stream);
+    return file;
+}
+
+void source_file_free(SourceFile* file) {
+    if (!file) return;
+    if (file->mapped) {
+        munmap(file->data, file->mapped);
+    } else {
+        free(file->data);
+    }
+    free(file);
+}
+
+void token_text(const char* source, const Token* token, char* buffer, size_t size) {
+    size_t len = (size_t)token->length;
+    if (len > size - 1) len = size - 1;
+    memcpy(buffer, source + token->start, len);
+    buffer[len] = '\0';
+}
+
+bool token_equals(const char* source, const Token* token, const char* text) {
+    return strlen(text) == (size_t)token->length &&
+           memcmp(source + token->start, text, token->length) == 0;
+}
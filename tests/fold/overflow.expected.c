@@ -0,0 +1,13 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+int main() {
+    int MIN = -2147483647 - 1;
+    printf("%d\n", 2147483647);
+    printf("%d\n", 2147483647 + 1);
+    printf("%d\n", MIN - 1);
+    printf("%d\n", 2147483647 * 2);
+    printf("%d\n", MIN / -1);
+    return 0;
+}
@@ -0,0 +1,23 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+int inner(int x) {
+    int M = x;
+    printf("%d\n", M);
+    return M + 4;
+    return 0;
+}
+
+int outer(int K) {
+    return K + 13;
+    return 0;
+}
+
+int main() {
+    printf("%d\n", 23);
+    printf("%d\n", 4);
+    printf("%d\n", inner(2));
+    printf("%d\n", outer(1));
+    return 0;
+}
@@ -0,0 +1,43 @@
+use anchor_lang::prelude::*;
+use anchor_spl::token::{self, Token, TokenAccount, Mint};
+use anchor_spl::associated_token::AssociatedToken;
+
+#[program]
+pub mod Escrow {
+    use super::*;
+
+    pub fn deposit(ctx: Context<depositContext>, amount: u64) -> Result<()> {
+        // Generated instruction logic
+        require!(amount > 0, EscrowError::InvalidAmount);
+        require!(amount < 1000000, ErrorCode::CustomError);
+        Ok(())
+    }
+
+}
+
+#[derive(Accounts)]
+pub struct depositContext<'info> {
+    #[account(init, payer = owner, space = 8 + 40)]
+    pub escrow: Account<'info, EscrowAccount>,
+    #[account(mut, signer)]
+    pub owner: Signer<'info>,
+    pub system_program: Program<'info, System>,
+}
+
+#[account]
+#[derive(Debug, PartialEq)]
+pub struct EscrowAccount {
+    pub owner: Pubkey,
+    pub amount: u64,
+}
+
+impl EscrowAccount {
+    pub const LEN: usize = 40;
+}
+
+#[error_code]
+pub enum EscrowError {
+    #[msg("Amount must be positive")]
+    InvalidAmount,
+}
+
@@ -0,0 +1,69 @@
+use solana_program::{
+    account_info::{next_account_info, AccountInfo},
+    entrypoint,
+    entrypoint::ProgramResult,
+    msg,
+    program_error::ProgramError,
+    pubkey::Pubkey,
+    system_instruction,
+    program::{invoke, invoke_signed},
+};
+use borsh::{BorshDeserialize, BorshSerialize};
+
+entrypoint!(process_instruction);
+
+pub fn process_instruction(
+    program_id: &Pubkey,
+    accounts: &[AccountInfo],
+    instruction_data: &[u8],
+) -> ProgramResult {
+    match instruction_data[0] {
+        0 => {
+            msg!("Executing deposit");
+            let accounts_iter = &mut accounts.iter();
+            let escrow = next_account_info(accounts_iter)?;
+            if !escrow.is_writable {
+                return Err(ProgramError::InvalidAccountData);
+            }
+            let owner = next_account_info(accounts_iter)?;
+            if !owner.is_signer {
+                return Err(ProgramError::MissingRequiredSignature);
+            }
+            if !owner.is_writable {
+                return Err(ProgramError::InvalidAccountData);
+            }
+            let mut instruction_args = &instruction_data[1..];
+            let amount: u64 = BorshDeserialize::deserialize(&mut instruction_args)
+                .map_err(|_| ProgramError::InvalidInstructionData)?;
+            if !(amount > 0) {
+                return Err(EscrowError::InvalidAmount.into());
+            }
+            if !(amount < 1000000) {
+                return Err(ProgramError::InvalidArgument);
+            }
+        },
+    }
+    Ok(())
+}
+
+#[derive(BorshSerialize, BorshDeserialize, Clone, Debug, PartialEq)]
+pub struct EscrowAccount {
+    pub owner: Pubkey,
+    pub amount: u64,
+}
+
+impl EscrowAccount {
+    pub const LEN: usize = 40;
+}
+
+#[derive(Clone, Copy, Debug, PartialEq, Eq)]
+pub enum EscrowError {
+    InvalidAmount = 0,
+}
+
+impl From<EscrowError> for ProgramError {
+    fn from(error: EscrowError) -> Self {
+        ProgramError::Custom(error as u32)
+    }
+}
+
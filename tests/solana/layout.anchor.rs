@@ -0,0 +1,57 @@
+use anchor_lang::prelude::*;
+use anchor_spl::token::{self, Token, TokenAccount, Mint};
+use anchor_spl::associated_token::AssociatedToken;
+
+#[program]
+pub mod Vault {
+    use super::*;
+
+    pub fn open(ctx: Context<openContext>, amount: u64) -> Result<()> {
+        // Generated instruction logic
+        require!(amount > 0, ErrorCode::CustomError);
+        Ok(())
+    }
+
+}
+
+#[derive(Accounts)]
+pub struct openContext<'info> {
+    #[account(init, payer = owner, space = 8 + 67)]
+    pub vault: Account<'info, Vault>,
+    #[account(mut, signer)]
+    pub owner: Signer<'info>,
+    pub system_program: Program<'info, System>,
+}
+
+#[derive(AnchorSerialize, AnchorDeserialize, Clone, Copy, Debug, PartialEq, Eq)]
+pub enum Status {
+    Open,
+    Closed,
+}
+
+#[account]
+#[derive(Debug, PartialEq)]
+pub struct Position {
+    pub amount: u64,
+    pub opened: i64,
+}
+
+impl Position {
+    pub const LEN: usize = 16;
+}
+
+#[account]
+#[derive(Debug, PartialEq)]
+pub struct Vault {
+    pub owner: Pubkey,
+    pub status: Status,
+    pub position: Position,
+    pub total: u128,
+    pub flags: u8,
+    pub bump: u8,
+}
+
+impl Vault {
+    pub const LEN: usize = 67;
+}
+
@@ -0,0 +1,75 @@
+use solana_program::{
+    account_info::{next_account_info, AccountInfo},
+    entrypoint,
+    entrypoint::ProgramResult,
+    msg,
+    program_error::ProgramError,
+    pubkey::Pubkey,
+    system_instruction,
+    program::{invoke, invoke_signed},
+};
+use borsh::{BorshDeserialize, BorshSerialize};
+
+entrypoint!(process_instruction);
+
+pub fn process_instruction(
+    program_id: &Pubkey,
+    accounts: &[AccountInfo],
+    instruction_data: &[u8],
+) -> ProgramResult {
+    match instruction_data[0] {
+        0 => {
+            msg!("Executing open");
+            let accounts_iter = &mut accounts.iter();
+            let vault = next_account_info(accounts_iter)?;
+            if !vault.is_writable {
+                return Err(ProgramError::InvalidAccountData);
+            }
+            let owner = next_account_info(accounts_iter)?;
+            if !owner.is_signer {
+                return Err(ProgramError::MissingRequiredSignature);
+            }
+            if !owner.is_writable {
+                return Err(ProgramError::InvalidAccountData);
+            }
+            let mut instruction_args = &instruction_data[1..];
+            let amount: u64 = BorshDeserialize::deserialize(&mut instruction_args)
+                .map_err(|_| ProgramError::InvalidInstructionData)?;
+            if !(amount > 0) {
+                return Err(ProgramError::InvalidArgument);
+            }
+        },
+    }
+    Ok(())
+}
+
+#[derive(BorshSerialize, BorshDeserialize, Clone, Copy, Debug, PartialEq, Eq)]
+pub enum Status {
+    Open,
+    Closed,
+}
+
+#[derive(BorshSerialize, BorshDeserialize, Clone, Debug, PartialEq)]
+pub struct Position {
+    pub amount: u64,
+    pub opened: i64,
+}
+
+impl Position {
+    pub const LEN: usize = 16;
+}
+
+#[derive(BorshSerialize, BorshDeserialize, Clone, Debug, PartialEq)]
+pub struct Vault {
+    pub owner: Pubkey,
+    pub status: Status,
+    pub position: Position,
+    pub total: u128,
+    pub flags: u8,
+    pub bump: u8,
+}
+
+impl Vault {
+    pub const LEN: usize = 67;
+}
+